@@ -0,0 +1,669 @@
+/*
+ * File: cache_policies.c
+ * Description: cache with a pluggable eviction policy, chosen at construction.
+ *
+ * - createCache(policy, capacity) returns a Cache; cacheGet/cachePut are the
+ *   same calls whatever the policy, so switching policy touches one line.
+ * - Each policy is an EvictionPolicy: a name plus get/put functions. The Cache
+ *   holds the storage they share: one preallocated node array, a key index
+ *   (open addressing, as in lru.c) and up to four intrusive lists. Nothing is
+ *   allocated after createCache.
+ * - cacheGet returns the value, or -1 if the key is not cached (like get in
+ *   lru.c). A miss does not insert; the caller puts the value it loaded.
+ *
+ * Policies:
+ * - LRU: the LRUCache from lru.c.
+ * - FIFO: evicts the oldest insertion; hits do not change the order.
+ * - LFU: evicts the least frequently used entry (least recently used among
+ *   equals). Entries hang off a list of frequency buckets in increasing order,
+ *   so a hit moves an entry to the next bucket and eviction takes from the
+ *   first one, both O(1).
+ * - 2Q: new keys enter a small FIFO (A1in, 1/4 of the capacity). Keys evicted
+ *   from it are remembered without values (A1out). Only a key that comes back
+ *   while remembered enters the main LRU (Am), so a one-pass scan cannot flush
+ *   the main list.
+ * - ARC: two LRU lists, T1 (seen once) and T2 (seen at least twice), plus
+ *   ghost lists B1/B2 of keys recently evicted from each. A ghost hit in B1
+ *   grows the target size of T1, a ghost hit in B2 shrinks it, so the split
+ *   between recency and frequency adapts to the workload.
+ * - W-TinyLFU: a small LRU window (1%) in front of a segmented LRU main area
+ *   (probation + protected, 80% protected). When the window overflows, its
+ *   oldest entry competes with the main area's eviction victim, and enters
+ *   only if a count-min sketch says it is accessed more often. Sketch counters
+ *   are halved periodically so old popularity fades.
+ *
+ * Frequency (LFU, W-TinyLFU) is counted on each hit and on each put, so a
+ * read-through miss (cacheGet then cachePut) counts once.
+ */
+
+#define LRU_NO_MAIN
+#include "../../memory_management/LRU_cache/lru.c"
+
+typedef enum PolicyType {
+    POLICY_LRU,
+    POLICY_FIFO,
+    POLICY_LFU,
+    POLICY_2Q,
+    POLICY_ARC,
+    POLICY_TINYLFU,
+    POLICY_COUNT
+} PolicyType;
+
+// Cache entry; ghost entries (2Q A1out, ARC B1/B2) keep only the key
+typedef struct PolicyNode {
+    int key;
+    int value;
+    uint32_t prev, next;
+    uint32_t bucket;  // LFU: frequency bucket of the entry
+    uint8_t list;     // Which of the cache's lists the node is on
+} PolicyNode;
+
+// Intrusive doubly linked list of node indices, most recent at the head
+typedef struct List {
+    uint32_t head, tail, size;
+} List;
+
+// LFU frequency bucket: all entries with the same count, most recent first
+typedef struct FreqBucket {
+    uint32_t freq;
+    List entries;
+    uint32_t prev, next;
+} FreqBucket;
+
+// Count-min sketch with 8-bit counters saturating at 15
+#define SKETCH_ROWS 4
+#define SKETCH_MAX 15
+
+typedef struct CountMinSketch {
+    uint8_t *counters;    // SKETCH_ROWS rows of `width` counters
+    uint32_t widthMask;
+    uint32_t samples;     // Increments since the last halving
+    uint32_t sampleLimit;
+} CountMinSketch;
+
+typedef struct KeyIndex {
+    IndexSlot *slots;
+    uint32_t mask;
+} KeyIndex;
+
+struct Cache;
+
+typedef struct EvictionPolicy {
+    const char *name;
+    int (*init)(struct Cache *cache);
+    int (*get)(struct Cache *cache, int key);
+    void (*put)(struct Cache *cache, int key, int value);
+} EvictionPolicy;
+
+typedef struct Cache {
+    const EvictionPolicy *policy;
+    uint32_t capacity;
+    uint32_t size;            // Entries with a value (ghosts not counted)
+
+    // Shared storage
+    PolicyNode *nodes;
+    uint32_t freeList;
+    KeyIndex index;
+    List lists[4];
+
+    // Policy state
+    uint32_t limits[2];       // 2Q: A1in, A1out sizes. W-TinyLFU: window, protected sizes
+    uint32_t target;          // ARC: target size of T1
+    FreqBucket *buckets;      // LFU
+    uint32_t freeBuckets, firstBucket;
+    CountMinSketch sketch;    // W-TinyLFU
+    LRUCache *lru;            // LRU
+} Cache;
+
+/* Key index: same layout and deletion scheme as the index in lru.c */
+
+static int keyIndexInit(KeyIndex *index, uint32_t entries) {
+    uint32_t slots = 2;
+    while (slots < 2 * (uint64_t)entries) slots *= 2;
+    index->slots = (IndexSlot *)malloc((size_t)slots * sizeof(IndexSlot));
+    if (!index->slots) return -1;
+    for (uint32_t i = 0; i < slots; i++) index->slots[i].node = NIL;
+    index->mask = slots - 1;
+    return 0;
+}
+
+static uint32_t keyIndexFind(const KeyIndex *index, int key) {
+    for (uint32_t slot = hashKey(key) & index->mask; index->slots[slot].node != NIL;
+         slot = (slot + 1) & index->mask) {
+        if (index->slots[slot].key == key) return index->slots[slot].node;
+    }
+    return NIL;
+}
+
+static void keyIndexAdd(KeyIndex *index, int key, uint32_t node) {
+    uint32_t slot = hashKey(key) & index->mask;
+    while (index->slots[slot].node != NIL) slot = (slot + 1) & index->mask;
+    index->slots[slot].key = key;
+    index->slots[slot].node = node;
+}
+
+static void keyIndexDelete(KeyIndex *index, int key) {
+    uint32_t mask = index->mask;
+    uint32_t hole = hashKey(key) & mask;
+    while (index->slots[hole].key != key || index->slots[hole].node == NIL) hole = (hole + 1) & mask;
+    for (uint32_t next = (hole + 1) & mask; index->slots[next].node != NIL; next = (next + 1) & mask) {
+        uint32_t home = hashKey(index->slots[next].key) & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            index->slots[hole] = index->slots[next];
+            hole = next;
+        }
+    }
+    index->slots[hole].node = NIL;
+}
+
+/* Lists */
+
+static void listInit(List *list) {
+    list->head = list->tail = NIL;
+    list->size = 0;
+}
+
+static void listPushHead(PolicyNode *nodes, List *list, uint32_t n) {
+    nodes[n].prev = NIL;
+    nodes[n].next = list->head;
+    if (list->head != NIL) nodes[list->head].prev = n;
+    list->head = n;
+    if (list->tail == NIL) list->tail = n;
+    list->size++;
+}
+
+static void listUnlink(PolicyNode *nodes, List *list, uint32_t n) {
+    if (nodes[n].prev != NIL) nodes[nodes[n].prev].next = nodes[n].next;
+    else list->head = nodes[n].next;
+    if (nodes[n].next != NIL) nodes[nodes[n].next].prev = nodes[n].prev;
+    else list->tail = nodes[n].prev;
+    list->size--;
+}
+
+// Move a node to the head of list `to` (which may be the list it is on)
+static void moveTo(Cache *cache, uint32_t n, uint8_t to) {
+    listUnlink(cache->nodes, &cache->lists[cache->nodes[n].list], n);
+    listPushHead(cache->nodes, &cache->lists[to], n);
+    cache->nodes[n].list = to;
+}
+
+/* Node pool */
+
+static int initStorage(Cache *cache, uint32_t nodes) {
+    cache->nodes = (PolicyNode *)malloc((size_t)nodes * sizeof(PolicyNode));
+    if (!cache->nodes || keyIndexInit(&cache->index, nodes) != 0) return -1;
+    for (uint32_t i = 0; i < nodes; i++) cache->nodes[i].next = i + 1 < nodes ? i + 1 : NIL;
+    cache->freeList = 0;
+    for (int i = 0; i < 4; i++) listInit(&cache->lists[i]);
+    return 0;
+}
+
+// Take a node from the pool and put it at the head of list `to`
+static uint32_t newNode(Cache *cache, int key, int value, uint8_t to) {
+    uint32_t n = cache->freeList;
+    cache->freeList = cache->nodes[n].next;
+    cache->nodes[n].key = key;
+    cache->nodes[n].value = value;
+    cache->nodes[n].list = to;
+    listPushHead(cache->nodes, &cache->lists[to], n);
+    keyIndexAdd(&cache->index, key, n);
+    return n;
+}
+
+// Unlink a node from its list and the index and return it to the pool
+static void dropNode(Cache *cache, uint32_t n) {
+    listUnlink(cache->nodes, &cache->lists[cache->nodes[n].list], n);
+    keyIndexDelete(&cache->index, cache->nodes[n].key);
+    cache->nodes[n].next = cache->freeList;
+    cache->freeList = n;
+}
+
+/* LRU: delegates to the LRUCache in lru.c */
+
+static int lruInit(Cache *cache) {
+    cache->lru = initCache(cache->capacity);
+    return cache->lru ? 0 : -1;
+}
+
+static int lruGet(Cache *cache, int key) {
+    return get(cache->lru, key);
+}
+
+static void lruPut(Cache *cache, int key, int value) {
+    put(cache->lru, key, value);
+    cache->size = cache->lru->size;
+}
+
+/* FIFO */
+
+static int fifoInit(Cache *cache) {
+    return initStorage(cache, cache->capacity);
+}
+
+static int fifoGet(Cache *cache, int key) {
+    uint32_t n = keyIndexFind(&cache->index, key);
+    return n == NIL ? -1 : cache->nodes[n].value;
+}
+
+static void fifoPut(Cache *cache, int key, int value) {
+    uint32_t n = keyIndexFind(&cache->index, key);
+    if (n != NIL) {
+        cache->nodes[n].value = value;
+        return;
+    }
+    if (cache->size == cache->capacity) {
+        dropNode(cache, cache->lists[0].tail);
+        cache->size--;
+    }
+    newNode(cache, key, value, 0);
+    cache->size++;
+}
+
+/* LFU with O(1) frequency buckets */
+
+static int lfuInit(Cache *cache) {
+    // Every non-empty bucket holds at least one entry, plus one while an entry moves
+    uint32_t buckets = cache->capacity + 1;
+    cache->buckets = (FreqBucket *)malloc((size_t)buckets * sizeof(FreqBucket));
+    if (!cache->buckets) return -1;
+    for (uint32_t i = 0; i < buckets; i++) cache->buckets[i].next = i + 1 < buckets ? i + 1 : NIL;
+    cache->freeBuckets = 0;
+    cache->firstBucket = NIL;
+    return initStorage(cache, cache->capacity);
+}
+
+// New bucket with count `freq`, linked after bucket `after` (or first if NIL)
+static uint32_t lfuNewBucket(Cache *cache, uint32_t freq, uint32_t after) {
+    uint32_t b = cache->freeBuckets;
+    FreqBucket *bucket = &cache->buckets[b];
+    cache->freeBuckets = bucket->next;
+    bucket->freq = freq;
+    listInit(&bucket->entries);
+    bucket->prev = after;
+    bucket->next = after == NIL ? cache->firstBucket : cache->buckets[after].next;
+    if (bucket->next != NIL) cache->buckets[bucket->next].prev = b;
+    if (after == NIL) cache->firstBucket = b;
+    else cache->buckets[after].next = b;
+    return b;
+}
+
+static void lfuDropBucket(Cache *cache, uint32_t b) {
+    FreqBucket *bucket = &cache->buckets[b];
+    if (bucket->prev != NIL) cache->buckets[bucket->prev].next = bucket->next;
+    else cache->firstBucket = bucket->next;
+    if (bucket->next != NIL) cache->buckets[bucket->next].prev = bucket->prev;
+    bucket->next = cache->freeBuckets;
+    cache->freeBuckets = b;
+}
+
+// Move an entry to the bucket for its count + 1
+static void lfuTouch(Cache *cache, uint32_t n) {
+    uint32_t b = cache->nodes[n].bucket;
+    uint32_t freq = cache->buckets[b].freq + 1;
+    uint32_t next = cache->buckets[b].next;
+    if (next == NIL || cache->buckets[next].freq != freq) {
+        next = lfuNewBucket(cache, freq, b);
+    }
+    listUnlink(cache->nodes, &cache->buckets[b].entries, n);
+    listPushHead(cache->nodes, &cache->buckets[next].entries, n);
+    cache->nodes[n].bucket = next;
+    if (cache->buckets[b].entries.size == 0) lfuDropBucket(cache, b);
+}
+
+static int lfuGet(Cache *cache, int key) {
+    uint32_t n = keyIndexFind(&cache->index, key);
+    if (n == NIL) return -1;
+    lfuTouch(cache, n);
+    return cache->nodes[n].value;
+}
+
+static void lfuPut(Cache *cache, int key, int value) {
+    uint32_t n = keyIndexFind(&cache->index, key);
+    if (n != NIL) {
+        cache->nodes[n].value = value;
+        lfuTouch(cache, n);
+        return;
+    }
+
+    if (cache->size == cache->capacity) {
+        // Least recently used entry of the lowest count
+        uint32_t b = cache->firstBucket;
+        uint32_t victim = cache->buckets[b].entries.tail;
+        listUnlink(cache->nodes, &cache->buckets[b].entries, victim);
+        if (cache->buckets[b].entries.size == 0) lfuDropBucket(cache, b);
+        keyIndexDelete(&cache->index, cache->nodes[victim].key);
+        cache->nodes[victim].next = cache->freeList;
+        cache->freeList = victim;
+        cache->size--;
+    }
+
+    uint32_t b = cache->firstBucket;
+    if (b == NIL || cache->buckets[b].freq != 1) b = lfuNewBucket(cache, 1, NIL);
+    n = cache->freeList;
+    cache->freeList = cache->nodes[n].next;
+    cache->nodes[n].key = key;
+    cache->nodes[n].value = value;
+    cache->nodes[n].bucket = b;
+    listPushHead(cache->nodes, &cache->buckets[b].entries, n);
+    keyIndexAdd(&cache->index, key, n);
+    cache->size++;
+}
+
+/* 2Q */
+
+enum { A1IN, A1OUT, AM };
+
+static int twoQInit(Cache *cache) {
+    cache->limits[0] = cache->capacity / 4 ? cache->capacity / 4 : 1;  // A1in entries
+    cache->limits[1] = cache->capacity / 2 ? cache->capacity / 2 : 1;  // A1out keys
+    return initStorage(cache, cache->capacity + cache->limits[1] + 1);
+}
+
+static int twoQGet(Cache *cache, int key) {
+    uint32_t n = keyIndexFind(&cache->index, key);
+    if (n == NIL || cache->nodes[n].list == A1OUT) return -1;
+    if (cache->nodes[n].list == AM) moveTo(cache, n, AM);  // A1in hits do not reorder
+    return cache->nodes[n].value;
+}
+
+// Free one entry's worth of room
+static void twoQReclaim(Cache *cache) {
+    List *a1in = &cache->lists[A1IN];
+    if (a1in->size > cache->limits[0] || cache->lists[AM].size == 0) {
+        // Oldest A1in entry becomes a remembered key
+        moveTo(cache, a1in->tail, A1OUT);
+        if (cache->lists[A1OUT].size > cache->limits[1]) dropNode(cache, cache->lists[A1OUT].tail);
+    } else {
+        dropNode(cache, cache->lists[AM].tail);
+    }
+    cache->size--;
+}
+
+static void twoQPut(Cache *cache, int key, int value) {
+    uint32_t n = keyIndexFind(&cache->index, key);
+    if (n != NIL && cache->nodes[n].list != A1OUT) {
+        cache->nodes[n].value = value;
+        if (cache->nodes[n].list == AM) moveTo(cache, n, AM);
+        return;
+    }
+
+    if (n != NIL) {
+        // Seen recently enough to be remembered: it goes to the main list.
+        // Take it off A1out first so reclaiming cannot drop it.
+        dropNode(cache, n);
+        if (cache->size == cache->capacity) twoQReclaim(cache);
+        newNode(cache, key, value, AM);
+    } else {
+        if (cache->size == cache->capacity) twoQReclaim(cache);
+        newNode(cache, key, value, A1IN);
+    }
+    cache->size++;
+}
+
+/* ARC */
+
+enum { T1, T2, B1, B2 };
+
+static int arcInit(Cache *cache) {
+    cache->target = 0;
+    return initStorage(cache, 2 * cache->capacity + 1);
+}
+
+static int arcGet(Cache *cache, int key) {
+    uint32_t n = keyIndexFind(&cache->index, key);
+    if (n == NIL || cache->nodes[n].list >= B1) return -1;
+    moveTo(cache, n, T2);
+    return cache->nodes[n].value;
+}
+
+// Evict one entry from T1 or T2 into its ghost list, steered by the target size of T1
+static void arcReplace(Cache *cache, int inB2) {
+    if (cache->size < cache->capacity) return;
+    uint32_t t1 = cache->lists[T1].size;
+    if (t1 > 0 && ((inB2 && t1 == cache->target) || t1 > cache->target || cache->lists[T2].size == 0)) {
+        moveTo(cache, cache->lists[T1].tail, B1);
+    } else {
+        moveTo(cache, cache->lists[T2].tail, B2);
+    }
+    cache->size--;
+}
+
+static void arcPut(Cache *cache, int key, int value) {
+    uint32_t n = keyIndexFind(&cache->index, key);
+    uint32_t b1 = cache->lists[B1].size, b2 = cache->lists[B2].size;
+
+    if (n != NIL && cache->nodes[n].list < B1) {
+        cache->nodes[n].value = value;
+        moveTo(cache, n, T2);
+        return;
+    }
+
+    if (n != NIL) {
+        // Ghost hit: adapt the target, then bring the key back as a frequent entry
+        int inB2 = cache->nodes[n].list == B2;
+        if (!inB2) {
+            uint32_t delta = b1 >= b2 ? 1 : b2 / b1;
+            cache->target = cache->target + delta < cache->capacity ? cache->target + delta : cache->capacity;
+        } else {
+            uint32_t delta = b2 >= b1 ? 1 : b1 / b2;
+            cache->target = cache->target > delta ? cache->target - delta : 0;
+        }
+        dropNode(cache, n);
+        arcReplace(cache, inB2);
+        newNode(cache, key, value, T2);
+        cache->size++;
+        return;
+    }
+
+    // New key
+    uint32_t t1 = cache->lists[T1].size;
+    if (t1 + b1 == cache->capacity) {
+        if (t1 < cache->capacity) {
+            dropNode(cache, cache->lists[B1].tail);
+            arcReplace(cache, 0);
+        } else {
+            dropNode(cache, cache->lists[T1].tail);  // B1 is empty: evict without a ghost
+            cache->size--;
+        }
+    } else {
+        uint32_t total = t1 + cache->lists[T2].size + b1 + b2;
+        if (total >= cache->capacity) {
+            if (total == 2 * cache->capacity) dropNode(cache, cache->lists[B2].tail);
+            arcReplace(cache, 0);
+        }
+    }
+    newNode(cache, key, value, T1);
+    cache->size++;
+}
+
+/* W-TinyLFU */
+
+enum { WINDOW, PROBATION, PROTECTED };
+
+static int sketchInit(CountMinSketch *sketch, uint32_t capacity) {
+    uint32_t width = 16;
+    while (width < capacity) width *= 2;
+    sketch->counters = (uint8_t *)calloc((size_t)SKETCH_ROWS * width, 1);
+    sketch->widthMask = width - 1;
+    sketch->samples = 0;
+    sketch->sampleLimit = 10 * width;
+    return sketch->counters ? 0 : -1;
+}
+
+// Counter for `key` in row `row` (double hashing)
+static uint8_t *sketchCounter(CountMinSketch *sketch, int key, int row) {
+    uint32_t h1 = hashKey(key);
+    uint32_t h2 = hashKey((int)(h1 ^ 0x9e3779b9u)) | 1;
+    return &sketch->counters[(size_t)row * (sketch->widthMask + 1) + ((h1 + row * h2) & sketch->widthMask)];
+}
+
+static void sketchIncrement(CountMinSketch *sketch, int key) {
+    for (int row = 0; row < SKETCH_ROWS; row++) {
+        uint8_t *counter = sketchCounter(sketch, key, row);
+        if (*counter < SKETCH_MAX) (*counter)++;
+    }
+    // Aging: halve every counter so the sketch follows changes in popularity
+    if (++sketch->samples == sketch->sampleLimit) {
+        size_t total = (size_t)SKETCH_ROWS * (sketch->widthMask + 1);
+        for (size_t i = 0; i < total; i++) sketch->counters[i] >>= 1;
+        sketch->samples /= 2;
+    }
+}
+
+static uint8_t sketchEstimate(CountMinSketch *sketch, int key) {
+    uint8_t estimate = SKETCH_MAX;
+    for (int row = 0; row < SKETCH_ROWS; row++) {
+        uint8_t counter = *sketchCounter(sketch, key, row);
+        if (counter < estimate) estimate = counter;
+    }
+    return estimate;
+}
+
+static int tinyLfuInit(Cache *cache) {
+    uint32_t window = cache->capacity / 100 ? cache->capacity / 100 : 1;
+    cache->limits[0] = window;
+    cache->limits[1] = (cache->capacity - window) * 8 / 10;  // Protected entries
+    if (sketchInit(&cache->sketch, cache->capacity) != 0) return -1;
+    return initStorage(cache, cache->capacity + 1);
+}
+
+static void tinyLfuTouch(Cache *cache, uint32_t n) {
+    switch (cache->nodes[n].list) {
+    case WINDOW:
+        moveTo(cache, n, WINDOW);
+        break;
+    case PROBATION:
+        // Second access in the main area: promote, demoting the oldest protected entry if needed
+        moveTo(cache, n, PROTECTED);
+        if (cache->lists[PROTECTED].size > cache->limits[1]) {
+            moveTo(cache, cache->lists[PROTECTED].tail, PROBATION);
+        }
+        break;
+    default:
+        moveTo(cache, n, PROTECTED);
+    }
+}
+
+static int tinyLfuGet(Cache *cache, int key) {
+    uint32_t n = keyIndexFind(&cache->index, key);
+    if (n == NIL) return -1;
+    sketchIncrement(&cache->sketch, key);
+    tinyLfuTouch(cache, n);
+    return cache->nodes[n].value;
+}
+
+static void tinyLfuPut(Cache *cache, int key, int value) {
+    sketchIncrement(&cache->sketch, key);
+    uint32_t n = keyIndexFind(&cache->index, key);
+    if (n != NIL) {
+        cache->nodes[n].value = value;
+        tinyLfuTouch(cache, n);
+        return;
+    }
+
+    newNode(cache, key, value, WINDOW);
+    cache->size++;
+    if (cache->lists[WINDOW].size <= cache->limits[0]) return;
+
+    // The window overflowed: its oldest entry is a candidate for the main area
+    uint32_t candidate = cache->lists[WINDOW].tail;
+    uint32_t mainSize = cache->lists[PROBATION].size + cache->lists[PROTECTED].size;
+    if (mainSize < cache->capacity - cache->limits[0]) {
+        moveTo(cache, candidate, PROBATION);
+        return;
+    }
+
+    uint32_t victim = cache->lists[PROBATION].tail;
+    if (victim == NIL) victim = cache->lists[PROTECTED].tail;
+    if (victim != NIL && sketchEstimate(&cache->sketch, cache->nodes[candidate].key) >
+                             sketchEstimate(&cache->sketch, cache->nodes[victim].key)) {
+        dropNode(cache, victim);
+        moveTo(cache, candidate, PROBATION);
+    } else {
+        dropNode(cache, candidate);  // Admission rejected
+    }
+    cache->size--;
+}
+
+static const EvictionPolicy policies[POLICY_COUNT] = {
+    [POLICY_LRU] = {"LRU", lruInit, lruGet, lruPut},
+    [POLICY_FIFO] = {"FIFO", fifoInit, fifoGet, fifoPut},
+    [POLICY_LFU] = {"LFU", lfuInit, lfuGet, lfuPut},
+    [POLICY_2Q] = {"2Q", twoQInit, twoQGet, twoQPut},
+    [POLICY_ARC] = {"ARC", arcInit, arcGet, arcPut},
+    [POLICY_TINYLFU] = {"W-TinyLFU", tinyLfuInit, tinyLfuGet, tinyLfuPut},
+};
+
+void destroyCache(Cache *cache) {
+    if (cache->lru) freeCache(cache->lru);
+    free(cache->nodes);
+    free(cache->index.slots);
+    free(cache->buckets);
+    free(cache->sketch.counters);
+    free(cache);
+}
+
+// Create a cache of `capacity` entries using the given eviction policy.
+// Returns NULL if out of memory or the capacity is 0.
+Cache *createCache(PolicyType type, uint32_t capacity) {
+    if (type >= POLICY_COUNT || capacity == 0 || capacity >= NIL / 4) return NULL;
+    Cache *cache = (Cache *)calloc(1, sizeof(Cache));
+    if (!cache) return NULL;
+    cache->policy = &policies[type];
+    cache->capacity = capacity;
+    if (cache->policy->init(cache) != 0) {
+        destroyCache(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+// Get a value from the cache, or -1 if the key is not cached
+int cacheGet(Cache *cache, int key) {
+    return cache->policy->get(cache, key);
+}
+
+// Put a key-value pair into the cache, evicting as the policy decides
+void cachePut(Cache *cache, int key, int value) {
+    cache->policy->put(cache, key, value);
+}
+
+const char *policyName(const Cache *cache) {
+    return cache->policy->name;
+}
+
+// Main function to compare the policies on a scan-heavy workload
+#ifndef CACHE_POLICIES_NO_MAIN
+#define CAPACITY 1000
+#define HOT_KEYS 800
+#define ROUNDS 200
+
+int main() {
+    for (int type = 0; type < POLICY_COUNT; type++) {
+        Cache *cache = createCache((PolicyType)type, CAPACITY);
+        unsigned int seed = 1;
+        long hits = 0, requests = 0;
+        int scanKey = 1000000;
+
+        for (int round = 0; round < ROUNDS; round++) {
+            // Hot working set that fits in the cache...
+            for (int i = 0; i < 5000; i++) {
+                int key = rand_r(&seed) % HOT_KEYS;
+                if (cacheGet(cache, key) != -1) hits++;
+                else cachePut(cache, key, key);
+                requests++;
+            }
+            // ...interrupted by a scan of keys that are never read again
+            for (int i = 0; i < CAPACITY; i++, scanKey++) {
+                if (cacheGet(cache, scanKey) != -1) hits++;
+                else cachePut(cache, scanKey, scanKey);
+                requests++;
+            }
+        }
+
+        printf("%-10s hit ratio %.3f (%u entries)\n", policyName(cache), (double)hits / requests, cache->size);
+        destroyCache(cache);
+    }
+    return 0;
+}
+#endif
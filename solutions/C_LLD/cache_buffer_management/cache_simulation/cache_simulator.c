@@ -0,0 +1,471 @@
+/*
+ * File: cache_simulator.c
+ * Description: replays a key trace against the caches in cache_policies.c and
+ * reports hit ratio and throughput per policy and capacity.
+ *
+ * Usage:
+ *   cache_simulator [-t] [-c cap,cap,...] [-p policy,policy,...] trace
+ *   cache_simulator -g count trace     (write a synthetic Zipf-like binary trace)
+ *
+ * - Trace formats: binary (default) is an array of native-endian 32-bit keys.
+ *   Text (-t) is decimal keys separated by any non-digit characters, e.g. one
+ *   per line; keys wider than 32 bits are folded to 32.
+ * - The trace is memory-mapped and read once, front to back. Pages already
+ *   processed are dropped with madvise, so a trace of many gigabytes does not
+ *   stay resident.
+ * - LRU curve (Mattson stack distances): the stack distance of an access is the
+ *   number of distinct keys used since the previous access to the same key,
+ *   itself included. An LRU cache of capacity C hits exactly when the distance
+ *   is at most C, so one histogram of distances gives the LRU hit ratio for
+ *   every capacity from a single pass. Distances are computed with a Fenwick
+ *   tree over access times holding a 1 at each key's latest access, so each
+ *   access costs O(log n). When the time axis fills up, live marks are packed
+ *   to the front; this keeps the tree proportional to the number of distinct
+ *   keys, not the trace length.
+ * - Policies (-p, default all): every (policy, capacity) cache is fed the same
+ *   keys in the same pass as a read-through cache (cacheGet, then cachePut on a
+ *   miss). Keys are decoded in batches and each cache's time on every batch is
+ *   measured, giving ops/sec per policy.
+ * - Capacities (-c) default to 1K, 4K, 16K, 64K and 256K entries. The LRU curve
+ *   is printed at these and at every power of two.
+ */
+
+#define _GNU_SOURCE                 // madvise and MADV_* under -std=c11
+#define CACHE_POLICIES_NO_MAIN
+#include "cache_policies.c"
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BATCH 65536
+#define MAX_CAPACITIES 32
+#define MAX_BOUNDARIES 64
+#define DROP_CHUNK (64u << 20)  // Bytes of processed trace released at a time
+
+/* Trace input */
+
+typedef struct Trace {
+    const unsigned char *data;
+    size_t length;
+    size_t offset;     // Next byte to decode
+    size_t dropped;    // Bytes already released with madvise
+    int text;
+} Trace;
+
+static int openTrace(Trace *trace, const char *path, int text) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    trace->length = (size_t)st.st_size;
+    trace->data = NULL;
+    if (trace->length > 0) {
+        void *map = mmap(NULL, trace->length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            return -1;
+        }
+        madvise(map, trace->length, MADV_SEQUENTIAL);
+        trace->data = (const unsigned char *)map;
+    }
+    close(fd);
+    trace->offset = trace->dropped = 0;
+    trace->text = text;
+    return 0;
+}
+
+// Release pages that have been decoded
+static void releaseProcessed(Trace *trace) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t end = trace->offset / page * page;
+    if (end - trace->dropped >= DROP_CHUNK) {
+        madvise((void *)(trace->data + trace->dropped), end - trace->dropped, MADV_DONTNEED);
+        trace->dropped = end;
+    }
+}
+
+// Decode up to `max` keys; returns how many were decoded (0 at the end)
+static size_t readKeys(Trace *trace, int *keys, size_t max) {
+    size_t n = 0;
+    if (!trace->text) {
+        size_t available = (trace->length - trace->offset) / sizeof(int);
+        n = available < max ? available : max;
+        memcpy(keys, trace->data + trace->offset, n * sizeof(int));
+        trace->offset += n * sizeof(int);
+    } else {
+        const unsigned char *p = trace->data;
+        size_t i = trace->offset;
+        while (n < max) {
+            while (i < trace->length && !isdigit(p[i])) i++;
+            if (i == trace->length) break;
+            uint64_t value = 0;
+            while (i < trace->length && isdigit(p[i])) value = value * 10 + (p[i++] - '0');
+            keys[n++] = (int)(uint32_t)(value ^ (value >> 32));
+        }
+        trace->offset = i;
+    }
+    releaseProcessed(trace);
+    return n;
+}
+
+/* Mattson stack distances */
+
+// Key -> position of its latest access on the time axis; grows as keys appear
+typedef struct PositionMap {
+    IndexSlot *slots;   // `node` holds the position, NIL if empty
+    uint32_t mask;
+    uint32_t count;
+} PositionMap;
+
+typedef struct StackDistance {
+    PositionMap positions;
+    uint32_t *tree;      // Fenwick tree over positions 1..size
+    int *keyAt;          // Key whose latest access is at a position
+    uint32_t size;
+    uint32_t now;        // Next free position
+    uint64_t boundaries[MAX_BOUNDARIES];   // Histogram bucket upper bounds, ascending
+    uint64_t counts[MAX_BOUNDARIES + 1];   // Last bucket: distance above every bound
+    int boundaryCount;
+    uint64_t coldMisses;
+    uint64_t accesses;
+} StackDistance;
+
+static int positionMapInit(PositionMap *map, uint32_t slots) {
+    map->slots = (IndexSlot *)malloc((size_t)slots * sizeof(IndexSlot));
+    if (!map->slots) return -1;
+    for (uint32_t i = 0; i < slots; i++) map->slots[i].node = NIL;
+    map->mask = slots - 1;
+    map->count = 0;
+    return 0;
+}
+
+// Slot for `key`, claiming an empty one if the key is new
+static IndexSlot *positionMapSlot(PositionMap *map, int key) {
+    uint32_t slot = hashKey(key) & map->mask;
+    while (map->slots[slot].node != NIL && map->slots[slot].key != key) slot = (slot + 1) & map->mask;
+    map->slots[slot].key = key;
+    return &map->slots[slot];
+}
+
+static int positionMapGrow(PositionMap *map) {
+    PositionMap bigger;
+    if (positionMapInit(&bigger, (map->mask + 1) * 2) != 0) return -1;
+    for (uint32_t i = 0; i <= map->mask; i++) {
+        if (map->slots[i].node != NIL) *positionMapSlot(&bigger, map->slots[i].key) = map->slots[i];
+    }
+    bigger.count = map->count;
+    free(map->slots);
+    *map = bigger;
+    return 0;
+}
+
+static uint32_t treePrefix(const StackDistance *sd, uint32_t pos) {
+    uint32_t sum = 0;
+    for (; pos > 0; pos &= pos - 1) sum += sd->tree[pos];
+    return sum;
+}
+
+static void treeAdd(StackDistance *sd, uint32_t pos, int delta) {
+    for (; pos <= sd->size; pos += pos & -pos) sd->tree[pos] += (uint32_t)delta;
+}
+
+static int stackDistanceInit(StackDistance *sd, const uint32_t *capacities, int capacityCount) {
+    memset(sd, 0, sizeof(*sd));
+    sd->size = 1 << 16;
+    sd->now = 1;
+    sd->tree = (uint32_t *)calloc((size_t)sd->size + 1, sizeof(uint32_t));
+    sd->keyAt = (int *)malloc(((size_t)sd->size + 1) * sizeof(int));
+    if (!sd->tree || !sd->keyAt || positionMapInit(&sd->positions, 1 << 16) != 0) return -1;
+
+    // Bucket bounds: every power of two, plus the requested capacities
+    for (int shift = 0; shift < 32; shift++) sd->boundaries[sd->boundaryCount++] = 1ull << shift;
+    for (int i = 0; i < capacityCount && sd->boundaryCount < MAX_BOUNDARIES; i++) {
+        sd->boundaries[sd->boundaryCount++] = capacities[i];
+    }
+    for (int i = 1; i < sd->boundaryCount; i++) {   // Insertion sort, dropping duplicates
+        uint64_t b = sd->boundaries[i];
+        int j = i - 1;
+        while (j >= 0 && sd->boundaries[j] > b) {
+            sd->boundaries[j + 1] = sd->boundaries[j];
+            j--;
+        }
+        sd->boundaries[j + 1] = b;
+    }
+    int unique = 0;
+    for (int i = 0; i < sd->boundaryCount; i++) {
+        if (unique == 0 || sd->boundaries[unique - 1] != sd->boundaries[i]) sd->boundaries[unique++] = sd->boundaries[i];
+    }
+    sd->boundaryCount = unique;
+    return 0;
+}
+
+// The time axis is full: move every key's mark to the front, in the same order,
+// growing the axis if more than half of it is live
+static int stackDistanceCompact(StackDistance *sd) {
+    uint32_t live = sd->positions.count;
+    uint32_t size = sd->size;
+    while (live > size / 2) size *= 2;
+
+    int *keyAt = (int *)malloc(((size_t)size + 1) * sizeof(int));
+    uint32_t *tree = (uint32_t *)calloc((size_t)size + 1, sizeof(uint32_t));
+    if (!keyAt || !tree) {
+        free(keyAt);
+        free(tree);
+        return -1;
+    }
+
+    uint32_t next = 1;
+    for (uint32_t pos = 1; pos < sd->now; pos++) {
+        IndexSlot *slot = positionMapSlot(&sd->positions, sd->keyAt[pos]);
+        if (slot->node == pos) {   // Still this key's latest access
+            slot->node = next;
+            keyAt[next] = sd->keyAt[pos];
+            tree[next] = 1;
+            next++;
+        }
+    }
+    // Linear-time Fenwick build over the marks
+    for (uint32_t pos = 1; pos <= size; pos++) {
+        uint32_t parent = pos + (pos & -pos);
+        if (parent <= size) tree[parent] += tree[pos];
+    }
+
+    free(sd->keyAt);
+    free(sd->tree);
+    sd->keyAt = keyAt;
+    sd->tree = tree;
+    sd->size = size;
+    sd->now = next;
+    return 0;
+}
+
+static int stackDistanceAccess(StackDistance *sd, int key) {
+    if (sd->now > sd->size && stackDistanceCompact(sd) != 0) return -1;
+    if (sd->positions.count * 2 > sd->positions.mask && positionMapGrow(&sd->positions) != 0) return -1;
+
+    sd->accesses++;
+    IndexSlot *slot = positionMapSlot(&sd->positions, key);
+    if (slot->node == NIL) {
+        sd->coldMisses++;
+        sd->positions.count++;
+    } else {
+        uint64_t distance = treePrefix(sd, sd->now - 1) - treePrefix(sd, slot->node - 1);
+        treeAdd(sd, slot->node, -1);
+        int lo = 0, hi = sd->boundaryCount;   // First bound >= distance
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (sd->boundaries[mid] < distance) lo = mid + 1;
+            else hi = mid;
+        }
+        sd->counts[lo]++;
+    }
+
+    slot->node = sd->now;
+    sd->keyAt[sd->now] = key;
+    treeAdd(sd, sd->now, 1);
+    sd->now++;
+    return 0;
+}
+
+// LRU hit ratio at a capacity that is one of the bucket bounds
+static double lruHitRatio(const StackDistance *sd, uint64_t capacity) {
+    uint64_t hits = 0;
+    for (int i = 0; i < sd->boundaryCount && sd->boundaries[i] <= capacity; i++) hits += sd->counts[i];
+    return sd->accesses ? (double)hits / sd->accesses : 0;
+}
+
+static void stackDistanceFree(StackDistance *sd) {
+    free(sd->tree);
+    free(sd->keyAt);
+    free(sd->positions.slots);
+}
+
+/* Driver */
+
+typedef struct Run {
+    Cache *cache;
+    uint32_t capacity;
+    uint64_t hits;
+    double seconds;
+} Run;
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int parseCapacities(const char *arg, uint32_t *capacities) {
+    int count = 0;
+    for (const char *p = arg; *p && count < MAX_CAPACITIES;) {
+        char *end;
+        unsigned long value = strtoul(p, &end, 10);
+        if (end == p || value == 0) return -1;
+        capacities[count++] = (uint32_t)value;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+static int parsePolicies(const char *arg, int *enabled) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", arg);
+    memset(enabled, 0, POLICY_COUNT * sizeof(int));
+    for (char *name = strtok(buffer, ","); name; name = strtok(NULL, ",")) {
+        int found = 0;
+        for (int type = 0; type < POLICY_COUNT; type++) {
+            if (strcasecmp(name, policies[type].name) == 0) enabled[type] = found = 1;
+        }
+        if (!found) return -1;
+    }
+    return 0;
+}
+
+// Write `count` keys with a skewed popularity and slowly drifting hot set
+static int generateTrace(const char *path, unsigned long count) {
+    FILE *file = fopen(path, "wb");
+    if (!file) return -1;
+    uint64_t state = 12345;
+    int keys[4096];
+    for (unsigned long i = 0; i < count;) {
+        int n = 0;
+        for (; n < 4096 && i < count; n++, i++) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            double u = (double)(state >> 11) / 9007199254740992.0;
+            keys[n] = (int)(1000000 * u * u * u * u) + (int)(i / 1000000) * 1000;
+        }
+        fwrite(keys, sizeof(int), (size_t)n, file);
+    }
+    return fclose(file);
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: cache_simulator [-t] [-c cap,cap,...] [-p policy,policy,...] trace\n"
+                    "       cache_simulator -g count trace\n");
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t capacities[MAX_CAPACITIES] = {1024, 4096, 16384, 65536, 262144};
+    int capacityCount = 5, text = 0, opt;
+    int enabled[POLICY_COUNT];
+    unsigned long generate = 0;
+    for (int type = 0; type < POLICY_COUNT; type++) enabled[type] = 1;
+
+    while ((opt = getopt(argc, argv, "tc:p:g:")) != -1) {
+        switch (opt) {
+        case 't': text = 1; break;
+        case 'c':
+            if ((capacityCount = parseCapacities(optarg, capacities)) <= 0) {
+                usage();
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'p':
+            if (parsePolicies(optarg, enabled) != 0) {
+                fprintf(stderr, "Unknown policy in %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'g': generate = strtoul(optarg, NULL, 10); break;
+        default: usage(); return EXIT_FAILURE;
+        }
+    }
+    if (optind != argc - 1) {
+        usage();
+        return EXIT_FAILURE;
+    }
+    const char *path = argv[optind];
+
+    if (generate) {
+        if (generateTrace(path, generate) != 0) {
+            fprintf(stderr, "Cannot write %s\n", path);
+            return EXIT_FAILURE;
+        }
+        printf("Wrote %lu keys to %s\n", generate, path);
+        return 0;
+    }
+
+    Trace trace;
+    if (openTrace(&trace, path, text) != 0) {
+        fprintf(stderr, "Cannot map %s\n", path);
+        return EXIT_FAILURE;
+    }
+
+    Run runs[POLICY_COUNT * MAX_CAPACITIES];
+    int runCount = 0;
+    for (int type = 0; type < POLICY_COUNT; type++) {
+        for (int i = 0; enabled[type] && i < capacityCount; i++) {
+            Run *run = &runs[runCount++];
+            run->cache = createCache((PolicyType)type, capacities[i]);
+            run->capacity = capacities[i];
+            run->hits = 0;
+            run->seconds = 0;
+            if (!run->cache) {
+                fprintf(stderr, "Out of memory for %s at %u entries\n", policies[type].name, capacities[i]);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    StackDistance sd;
+    if (stackDistanceInit(&sd, capacities, capacityCount) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    int *keys = (int *)malloc(BATCH * sizeof(int));
+    double mattsonSeconds = 0;
+    size_t n;
+    while ((n = readKeys(&trace, keys, BATCH)) > 0) {
+        double start = nowSeconds();
+        for (size_t i = 0; i < n; i++) {
+            if (stackDistanceAccess(&sd, keys[i]) != 0) {
+                fprintf(stderr, "Out of memory\n");
+                return EXIT_FAILURE;
+            }
+        }
+        mattsonSeconds += nowSeconds() - start;
+
+        for (int r = 0; r < runCount; r++) {
+            Run *run = &runs[r];
+            start = nowSeconds();
+            for (size_t i = 0; i < n; i++) {
+                if (cacheGet(run->cache, keys[i]) != -1) run->hits++;
+                else cachePut(run->cache, keys[i], 0);
+            }
+            run->seconds += nowSeconds() - start;
+        }
+    }
+
+    printf("Trace: %llu accesses, %u distinct keys\n\n", (unsigned long long)sd.accesses, sd.positions.count);
+
+    printf("LRU hit ratio curve (stack distance, %.1f M accesses/s):\n",
+           mattsonSeconds > 0 ? sd.accesses / mattsonSeconds / 1e6 : 0);
+    printf("%12s %10s\n", "capacity", "hit ratio");
+    for (int i = 0; i < sd.boundaryCount; i++) {
+        printf("%12llu %10.4f\n", (unsigned long long)sd.boundaries[i], lruHitRatio(&sd, sd.boundaries[i]));
+        if (sd.boundaries[i] >= sd.positions.count) break;   // Every later capacity holds every key
+    }
+
+    printf("\n%-10s %12s %10s %12s\n", "policy", "capacity", "hit ratio", "M ops/s");
+    for (int r = 0; r < runCount; r++) {
+        Run *run = &runs[r];
+        printf("%-10s %12u %10.4f %12.2f\n", policyName(run->cache), run->capacity,
+               sd.accesses ? (double)run->hits / sd.accesses : 0,
+               run->seconds > 0 ? sd.accesses / run->seconds / 1e6 : 0);
+        destroyCache(run->cache);
+    }
+
+    free(keys);
+    stackDistanceFree(&sd);
+    if (trace.data) munmap((void *)trace.data, trace.length);
+    return 0;
+}
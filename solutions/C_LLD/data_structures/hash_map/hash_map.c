@@ -2,7 +2,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifndef TABLE_SIZE
 #define TABLE_SIZE 10 // Define the size of the hash table
+#endif
 
 // Node structure for chaining (linked list)
 typedef struct Node {
@@ -37,22 +39,22 @@ void initializeHashMap(HashMap* map) {
     }
 }
 
-// Insert key-value pair into the hash map
+// Insert key-value pair into the hash map, updating the value if the key exists
 void insert(HashMap* map, int key, int value) {
     unsigned int index = hash(key);
-    Node* newNode = createNode(key, value);
 
-    // If no collision
-    if (map->table[index] == NULL) {
-        map->table[index] = newNode;
-    } else {
-        // Collision: use chaining (linked list)
-        Node* temp = map->table[index];
-        while (temp->next != NULL) {
-            temp = temp->next;
+    // Check the chain for the key first so duplicates never pile up
+    for (Node* temp = map->table[index]; temp != NULL; temp = temp->next) {
+        if (temp->key == key) {
+            temp->value = value;
+            return;
         }
-        temp->next = newNode;
     }
+
+    // Key not present: chain the new node at the head (handles collisions too)
+    Node* newNode = createNode(key, value);
+    newNode->next = map->table[index];
+    map->table[index] = newNode;
 }
 
 // Search for a value by key in the hash map
@@ -70,8 +72,8 @@ int search(HashMap* map, int key) {
     return -1; // Key not found
 }
 
-// Delete a key-value pair from the hash map
-void delete(HashMap* map, int key) {
+// Delete a key-value pair from the hash map; returns 1 if deleted, 0 if not found
+int delete(HashMap* map, int key) {
     unsigned int index = hash(key);
     Node* temp = map->table[index];
     Node* prev = NULL;
@@ -82,8 +84,7 @@ void delete(HashMap* map, int key) {
     }
 
     if (temp == NULL) {
-        printf("Key not found\n");
-        return;
+        return 0;
     }
 
     if (prev == NULL) {
@@ -93,7 +94,7 @@ void delete(HashMap* map, int key) {
     }
 
     free(temp);
-    printf("Key deleted\n");
+    return 1;
 }
 
 // Display the hash map
@@ -109,6 +110,7 @@ void display(HashMap* map) {
     }
 }
 
+#ifndef HASH_MAP_NO_MAIN
 // Main function to demonstrate the hash map operations
 int main() {
     HashMap map;
@@ -128,9 +130,10 @@ int main() {
         printf("Key not found\n");
     }
 
-    delete(&map, 1);
+    printf(delete(&map, 1) ? "Key deleted\n" : "Key not found\n");
     printf("HashMap after deletion:\n");
     display(&map);
 
     return 0;
 }
+#endif
@@ -0,0 +1,321 @@
+/*
+ * File: hash_map02.c
+ * Description: resizable hash map keyed on byte strings (ptr, len).
+ *
+ * - Keys are arbitrary bytes and are copied into the entry, so callers may
+ *   reuse their key buffers. Values are opaque pointers owned by the caller.
+ * - Each entry caches the full 64-bit hash of its key. A lookup only calls
+ *   memcmp when hash and length both match, and resizing relinks entries
+ *   without hashing any key again.
+ * - The bucket count is a power of two and doubles when the entry count
+ *   passes it (load factor 1).
+ * - Entries come from a chunked arena: 64 KB chunks carved into 16-byte
+ *   granules, with one free list per entry size. bytesMapDelete puts the
+ *   entry on its free list and the next insert of a similar key reuses it,
+ *   so a steady workload stops calling malloc. Entries larger than the
+ *   biggest size class (keys over ~220 bytes) fall back to malloc/free.
+ * - bytesMapPut has upsert semantics: an existing key has its value replaced.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_BUCKETS 16
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#define GRANULE 16
+#define NUM_SIZE_CLASSES 16                           // Entries up to 256 bytes use the arena
+#define MAX_ARENA_ENTRY (GRANULE * NUM_SIZE_CLASSES)
+
+// Entry with the key bytes stored inline after the header
+typedef struct Entry {
+    struct Entry *next;
+    uint64_t hash;
+    void *value;
+    size_t keyLen;
+    unsigned char key[];
+} Entry;
+
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;
+    size_t used;                                      // Bytes handed out from this chunk
+} ArenaChunk;
+
+// Free blocks are linked through their first word
+typedef struct FreeBlock {
+    struct FreeBlock *next;
+} FreeBlock;
+
+typedef struct Arena {
+    ArenaChunk *chunks;                               // Newest first; only the head has room
+    FreeBlock *freeLists[NUM_SIZE_CLASSES];
+} Arena;
+
+typedef struct BytesMap {
+    Entry **buckets;
+    size_t bucketCount;                               // Power of two
+    size_t count;
+    Arena arena;
+} BytesMap;
+
+// FNV-1a over the key, finished with the MurmurHash3 mixer so the low bits
+// used for the bucket index are well distributed
+uint64_t hashBytes(const void *key, size_t len) {
+    const unsigned char *p = (const unsigned char *)key;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static size_t entrySize(size_t keyLen) {
+    return (sizeof(Entry) + keyLen + GRANULE - 1) & ~(size_t)(GRANULE - 1);
+}
+
+static size_t chunkHeaderSize(void) {
+    return (sizeof(ArenaChunk) + GRANULE - 1) & ~(size_t)(GRANULE - 1);
+}
+
+void arenaInit(Arena *arena) {
+    arena->chunks = NULL;
+    memset(arena->freeLists, 0, sizeof(arena->freeLists));
+}
+
+// Allocate `size` bytes (a multiple of GRANULE): free list first, then the
+// current chunk, then a new chunk. Oversized requests go to malloc.
+void *arenaAlloc(Arena *arena, size_t size) {
+    if (size > MAX_ARENA_ENTRY) {
+        return malloc(size);
+    }
+
+    size_t sizeClass = size / GRANULE - 1;
+    if (arena->freeLists[sizeClass] != NULL) {
+        FreeBlock *block = arena->freeLists[sizeClass];
+        arena->freeLists[sizeClass] = block->next;
+        return block;
+    }
+
+    ArenaChunk *chunk = arena->chunks;
+    if (chunk == NULL || chunk->used + size > ARENA_CHUNK_SIZE) {
+        chunk = (ArenaChunk *)malloc(ARENA_CHUNK_SIZE);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        chunk->next = arena->chunks;
+        chunk->used = chunkHeaderSize();
+        arena->chunks = chunk;
+    }
+
+    void *block = (unsigned char *)chunk + chunk->used;
+    chunk->used += size;
+    return block;
+}
+
+// Return a block to the free list of its size class
+void arenaFree(Arena *arena, void *block, size_t size) {
+    if (size > MAX_ARENA_ENTRY) {
+        free(block);
+        return;
+    }
+
+    size_t sizeClass = size / GRANULE - 1;
+    FreeBlock *freeBlock = (FreeBlock *)block;
+    freeBlock->next = arena->freeLists[sizeClass];
+    arena->freeLists[sizeClass] = freeBlock;
+}
+
+void arenaDestroy(Arena *arena) {
+    ArenaChunk *chunk = arena->chunks;
+    while (chunk != NULL) {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arenaInit(arena);
+}
+
+// Initialize the map; returns 0 on success, -1 if out of memory
+int bytesMapInit(BytesMap *map, size_t initialBuckets) {
+    size_t n = INITIAL_BUCKETS;
+    while (n < initialBuckets) {
+        n *= 2;
+    }
+    map->buckets = (Entry **)calloc(n, sizeof(Entry *));
+    if (map->buckets == NULL) {
+        return -1;
+    }
+    map->bucketCount = n;
+    map->count = 0;
+    arenaInit(&map->arena);
+    return 0;
+}
+
+// Double the bucket array and relink every entry using its cached hash
+static void bytesMapGrow(BytesMap *map) {
+    size_t newCount = map->bucketCount * 2;
+    Entry **newBuckets = (Entry **)calloc(newCount, sizeof(Entry *));
+    if (newBuckets == NULL) {
+        return;  // Keep working at a higher load factor
+    }
+
+    for (size_t i = 0; i < map->bucketCount; i++) {
+        Entry *entry = map->buckets[i];
+        while (entry != NULL) {
+            Entry *next = entry->next;
+            size_t index = entry->hash & (newCount - 1);
+            entry->next = newBuckets[index];
+            newBuckets[index] = entry;
+            entry = next;
+        }
+    }
+
+    free(map->buckets);
+    map->buckets = newBuckets;
+    map->bucketCount = newCount;
+}
+
+static int keyMatches(const Entry *entry, uint64_t hash, const void *key, size_t len) {
+    return entry->hash == hash && entry->keyLen == len && memcmp(entry->key, key, len) == 0;
+}
+
+// Insert or update. Returns 1 if the key was added, 0 if its value was
+// replaced, -1 if out of memory.
+int bytesMapPut(BytesMap *map, const void *key, size_t len, void *value) {
+    uint64_t hash = hashBytes(key, len);
+    size_t index = hash & (map->bucketCount - 1);
+
+    for (Entry *entry = map->buckets[index]; entry != NULL; entry = entry->next) {
+        if (keyMatches(entry, hash, key, len)) {
+            entry->value = value;
+            return 0;
+        }
+    }
+
+    Entry *entry = (Entry *)arenaAlloc(&map->arena, entrySize(len));
+    if (entry == NULL) {
+        return -1;
+    }
+    entry->hash = hash;
+    entry->value = value;
+    entry->keyLen = len;
+    memcpy(entry->key, key, len);
+
+    // New entries go to the head of the chain: no walk to the tail
+    entry->next = map->buckets[index];
+    map->buckets[index] = entry;
+    map->count++;
+
+    if (map->count > map->bucketCount) {
+        bytesMapGrow(map);
+    }
+    return 1;
+}
+
+// Look up a key. Returns 1 and stores the value in *value if found, else 0.
+int bytesMapGet(const BytesMap *map, const void *key, size_t len, void **value) {
+    uint64_t hash = hashBytes(key, len);
+    for (Entry *entry = map->buckets[hash & (map->bucketCount - 1)]; entry != NULL; entry = entry->next) {
+        if (keyMatches(entry, hash, key, len)) {
+            if (value != NULL) {
+                *value = entry->value;
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Remove a key. Returns 1 if it was present, else 0.
+int bytesMapDelete(BytesMap *map, const void *key, size_t len) {
+    uint64_t hash = hashBytes(key, len);
+    Entry **link = &map->buckets[hash & (map->bucketCount - 1)];
+
+    while (*link != NULL) {
+        Entry *entry = *link;
+        if (keyMatches(entry, hash, key, len)) {
+            *link = entry->next;
+            arenaFree(&map->arena, entry, entrySize(entry->keyLen));
+            map->count--;
+            return 1;
+        }
+        link = &entry->next;
+    }
+    return 0;
+}
+
+// Release the bucket array and every arena chunk
+void bytesMapFree(BytesMap *map) {
+    for (size_t i = 0; i < map->bucketCount; i++) {
+        for (Entry *entry = map->buckets[i]; entry != NULL;) {
+            Entry *next = entry->next;
+            if (entrySize(entry->keyLen) > MAX_ARENA_ENTRY) {
+                free(entry);
+            }
+            entry = next;
+        }
+    }
+    free(map->buckets);
+    map->buckets = NULL;
+    map->bucketCount = 0;
+    map->count = 0;
+    arenaDestroy(&map->arena);
+}
+
+// Display the map; keys are printed as text, which suits the example below
+void bytesMapDisplay(const BytesMap *map) {
+    for (size_t i = 0; i < map->bucketCount; i++) {
+        if (map->buckets[i] == NULL) {
+            continue;
+        }
+        printf("Index %zu: ", i);
+        for (Entry *entry = map->buckets[i]; entry != NULL; entry = entry->next) {
+            printf("(%.*s, %p) -> ", (int)entry->keyLen, (const char *)entry->key, entry->value);
+        }
+        printf("NULL\n");
+    }
+}
+
+// Main function to demonstrate the byte-string hash map
+int main() {
+    BytesMap map;
+    if (bytesMapInit(&map, 4) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    int apple = 10, banana = 20, cherry = 30, apricot = 40;
+    bytesMapPut(&map, "apple", 5, &apple);
+    bytesMapPut(&map, "banana", 6, &banana);
+    bytesMapPut(&map, "cherry", 6, &cherry);
+    printf("Inserted again: %d\n", bytesMapPut(&map, "apple", 5, &apricot));  // Upsert, prints 0
+
+    printf("HashMap after insertions:\n");
+    bytesMapDisplay(&map);
+
+    void *value;
+    if (bytesMapGet(&map, "apple", 5, &value)) {
+        printf("Value for apple: %d\n", *(int *)value);
+    }
+
+    bytesMapDelete(&map, "banana", 6);
+    printf("banana present after delete: %d\n", bytesMapGet(&map, "banana", 6, NULL));
+
+    // Grow well past the initial bucket count; deleted entries are recycled
+    char key[32];
+    for (int i = 0; i < 1000; i++) {
+        int len = snprintf(key, sizeof(key), "key-%d", i);
+        bytesMapPut(&map, key, (size_t)len, NULL);
+    }
+    printf("Entries: %zu, buckets: %zu\n", map.count, map.bucketCount);
+
+    bytesMapFree(&map);
+    return 0;
+}
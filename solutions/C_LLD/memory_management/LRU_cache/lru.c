@@ -1,166 +1,255 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define CAPACITY 5  // Cache capacity
+#define NIL UINT32_MAX  // "No node" in list links and index slots
 
-// Node for the doubly linked list
+// Node for the doubly linked list. Nodes live in one preallocated array and
+// link to each other by array index, not by pointer.
 typedef struct Node {
     int key;
     int value;
-    struct Node *prev, *next;
+    uint32_t prev, next;
 } Node;
 
-// Hash table entry
-typedef struct HashEntry {
-    Node *node;
-} HashEntry;
+// Hash index slot: the key is kept next to the node index, so a probe does not
+// have to touch the node array until the key matches
+typedef struct IndexSlot {
+    int key;
+    uint32_t node;  // NIL if the slot is empty
+} IndexSlot;
 
 // LRU Cache structure
 typedef struct LRUCache {
-    int capacity;
-    int size;
-    Node *head, *tail;
-    HashEntry *hashTable[CAPACITY];
+    uint32_t capacity;
+    uint32_t size;
+    uint32_t head, tail;  // Most and least recently used node
+    uint32_t freeList;    // Unused nodes, linked through `next`
+    Node *nodes;          // `capacity` nodes
+    IndexSlot *index;     // Open addressing with linear probing
+    uint32_t indexMask;   // Slot count - 1; slot count is a power of two >= 2 * capacity
 } LRUCache;
 
-// Create a new doubly linked list node
-Node* createNode(int key, int value) {
-    Node *newNode = (Node *)malloc(sizeof(Node));
-    newNode->key = key;
-    newNode->value = value;
-    newNode->prev = newNode->next = NULL;
-    return newNode;
+// Mix the key so that sequential keys spread over the whole index
+static uint32_t hashKey(int key) {
+    uint32_t h = (uint32_t)key;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
 }
 
-// Initialize the LRU Cache
-LRUCache* initCache(int capacity) {
-    LRUCache *cache = (LRUCache *)malloc(sizeof(LRUCache));
-    cache->capacity = capacity;
-    cache->size = 0;
-    cache->head = cache->tail = NULL;
-    memset(cache->hashTable, 0, sizeof(cache->hashTable));
-    return cache;
+// Index slot holding `key`, or NIL if the key is not cached
+static uint32_t indexFind(const LRUCache *cache, int key) {
+    uint32_t slot = hashKey(key) & cache->indexMask;
+    while (cache->index[slot].node != NIL) {
+        if (cache->index[slot].key == key) return slot;
+        slot = (slot + 1) & cache->indexMask;
+    }
+    return NIL;
 }
 
-// Move a node to the front (head) of the list
-void moveToHead(LRUCache *cache, Node *node) {
-    if (cache->head == node) return;  // It's already the head
-
-    // Remove the node from its current position
-    if (node->prev) node->prev->next = node->next;
-    if (node->next) node->next->prev = node->prev;
+// Add a key that is known to be absent
+static void indexInsert(LRUCache *cache, int key, uint32_t node) {
+    uint32_t slot = hashKey(key) & cache->indexMask;
+    while (cache->index[slot].node != NIL) {
+        slot = (slot + 1) & cache->indexMask;
+    }
+    cache->index[slot].key = key;
+    cache->index[slot].node = node;
+}
 
-    // If it was the tail, update the tail
-    if (node == cache->tail) cache->tail = node->prev;
+// Empty a slot and shift later entries of the probe run back into the hole,
+// so no tombstones build up however long the cache runs
+static void indexRemove(LRUCache *cache, uint32_t slot) {
+    uint32_t mask = cache->indexMask;
+    uint32_t hole = slot;
+    for (uint32_t next = (hole + 1) & mask; cache->index[next].node != NIL; next = (next + 1) & mask) {
+        uint32_t home = hashKey(cache->index[next].key) & mask;
+        // Move the entry only if its home slot is not between the hole and its position
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            cache->index[hole] = cache->index[next];
+            hole = next;
+        }
+    }
+    cache->index[hole].node = NIL;
+}
 
-    // Move the node to the front (head)
-    node->next = cache->head;
-    node->prev = NULL;
-    if (cache->head) cache->head->prev = node;
-    cache->head = node;
+// Allocate the node array and index for `capacity` entries and link every node
+// into the free list. Returns 0 on success, -1 if out of memory.
+static int allocStorage(LRUCache *cache, uint32_t capacity) {
+    uint32_t slots = 2;
+    while (slots < 2 * (uint64_t)capacity) slots *= 2;
+
+    Node *nodes = (Node *)malloc((size_t)capacity * sizeof(Node));
+    IndexSlot *index = (IndexSlot *)malloc((size_t)slots * sizeof(IndexSlot));
+    if (!nodes || !index) {
+        free(nodes);
+        free(index);
+        return -1;
+    }
+    for (uint32_t i = 0; i < slots; i++) index[i].node = NIL;
+    for (uint32_t i = 0; i < capacity; i++) nodes[i].next = i + 1 < capacity ? i + 1 : NIL;
 
-    // If there's no tail (only one element), update it
-    if (!cache->tail) cache->tail = node;
+    cache->capacity = capacity;
+    cache->size = 0;
+    cache->head = cache->tail = NIL;
+    cache->freeList = capacity ? 0 : NIL;
+    cache->nodes = nodes;
+    cache->index = index;
+    cache->indexMask = slots - 1;
+    return 0;
 }
 
-// Remove the tail (least recently used item)
-void removeTail(LRUCache *cache) {
-    if (!cache->tail) return;
-
-    Node *oldTail = cache->tail;
+// Initialize the LRU Cache. All memory is allocated here; get and put never allocate.
+// Returns NULL if out of memory.
+LRUCache* initCache(uint32_t capacity) {
+    if (capacity >= NIL / 2) return NULL;
+    LRUCache *cache = (LRUCache *)malloc(sizeof(LRUCache));
+    if (!cache) return NULL;
+    if (allocStorage(cache, capacity) != 0) {
+        free(cache);
+        return NULL;
+    }
+    return cache;
+}
 
-    // Update the tail pointer
-    cache->tail = oldTail->prev;
-    if (cache->tail) cache->tail->next = NULL;
+// Unlink a node from the list
+static void detach(LRUCache *cache, uint32_t n) {
+    Node *node = &cache->nodes[n];
+    if (node->prev != NIL) cache->nodes[node->prev].next = node->next;
+    else cache->head = node->next;
+    if (node->next != NIL) cache->nodes[node->next].prev = node->prev;
+    else cache->tail = node->prev;
+}
 
-    // Remove from hash table
-    cache->hashTable[oldTail->key % CAPACITY] = NULL;
+// Insert a node at the front (head) of the list
+void insertAtHead(LRUCache *cache, uint32_t n) {
+    Node *node = &cache->nodes[n];
+    node->prev = NIL;
+    node->next = cache->head;
+    if (cache->head != NIL) cache->nodes[cache->head].prev = n;
+    cache->head = n;
+    if (cache->tail == NIL) cache->tail = n;
+}
 
-    free(oldTail);
-    cache->size--;
+// Move a node to the front (head) of the list
+void moveToHead(LRUCache *cache, uint32_t n) {
+    if (cache->head == n) return;  // It's already the head
+    detach(cache, n);
+    insertAtHead(cache, n);
 }
 
-// Insert a new node at the front (head) of the list
-void insertAtHead(LRUCache *cache, Node *node) {
-    node->next = cache->head;
-    node->prev = NULL;
+// Remove the tail (least recently used item) and return its node to the free list
+void removeTail(LRUCache *cache) {
+    uint32_t n = cache->tail;
+    if (n == NIL) return;
 
-    if (cache->head) cache->head->prev = node;
-    cache->head = node;
+    detach(cache, n);
+    indexRemove(cache, indexFind(cache, cache->nodes[n].key));
 
-    if (!cache->tail) cache->tail = node;
+    cache->nodes[n].next = cache->freeList;
+    cache->freeList = n;
+    cache->size--;
 }
 
 // Get a value from the cache
 int get(LRUCache *cache, int key) {
-    int hashIndex = key % CAPACITY;
-    HashEntry *entry = cache->hashTable[hashIndex];
+    uint32_t slot = indexFind(cache, key);
+    if (slot == NIL) return -1;  // Key not found
 
-    if (entry && entry->node && entry->node->key == key) {
-        // Move the accessed node to the front (most recently used)
-        moveToHead(cache, entry->node);
-        return entry->node->value;
-    }
-
-    return -1;  // Key not found
+    // Move the accessed node to the front (most recently used)
+    uint32_t n = cache->index[slot].node;
+    moveToHead(cache, n);
+    return cache->nodes[n].value;
 }
 
 // Put a key-value pair into the cache
 void put(LRUCache *cache, int key, int value) {
-    int hashIndex = key % CAPACITY;
-    HashEntry *entry = cache->hashTable[hashIndex];
-
-    if (entry && entry->node && entry->node->key == key) {
-        // Update the value of the existing node
-        entry->node->value = value;
-        // Move the node to the front (most recently used)
-        moveToHead(cache, entry->node);
-    } else {
-        // If the cache is full, remove the least recently used item (tail)
-        if (cache->size == cache->capacity) {
-            removeTail(cache);
-        }
+    if (cache->capacity == 0) return;
+
+    uint32_t slot = indexFind(cache, key);
+    if (slot != NIL) {
+        // Update the value of the existing node and make it the most recently used
+        uint32_t n = cache->index[slot].node;
+        cache->nodes[n].value = value;
+        moveToHead(cache, n);
+        return;
+    }
 
-        // Create a new node
-        Node *newNode = createNode(key, value);
+    // If the cache is full, remove the least recently used item (tail)
+    if (cache->size == cache->capacity) {
+        removeTail(cache);
+    }
+
+    // Take a node from the free list
+    uint32_t n = cache->freeList;
+    cache->freeList = cache->nodes[n].next;
+    cache->nodes[n].key = key;
+    cache->nodes[n].value = value;
 
-        // Insert the new node at the front (head)
-        insertAtHead(cache, newNode);
+    insertAtHead(cache, n);
+    indexInsert(cache, key, n);
+    cache->size++;
+}
 
-        // Add to the hash table
-        cache->hashTable[hashIndex] = (HashEntry *)malloc(sizeof(HashEntry));
-        cache->hashTable[hashIndex]->node = newNode;
+// Change the capacity. Least recently used entries are evicted if the cache
+// shrinks below its size; the rest keep their recency order.
+// Returns 0 on success, -1 if out of memory (the cache is left unchanged).
+int resizeCache(LRUCache *cache, uint32_t capacity) {
+    if (capacity >= NIL / 2) return -1;
 
-        cache->size++;
+    LRUCache resized;
+    if (allocStorage(&resized, capacity) != 0) return -1;
+
+    while (cache->size > capacity) {
+        removeTail(cache);
+    }
+
+    // Copy from the tail so that each insert at the head preserves the order
+    for (uint32_t n = cache->tail; n != NIL; n = cache->nodes[n].prev) {
+        uint32_t m = resized.freeList;
+        resized.freeList = resized.nodes[m].next;
+        resized.nodes[m].key = cache->nodes[n].key;
+        resized.nodes[m].value = cache->nodes[n].value;
+        insertAtHead(&resized, m);
+        indexInsert(&resized, resized.nodes[m].key, m);
+        resized.size++;
     }
+
+    free(cache->nodes);
+    free(cache->index);
+    *cache = resized;
+    return 0;
 }
 
 // Print the contents of the cache
 void printCache(LRUCache *cache) {
-    Node *current = cache->head;
     printf("Cache: ");
-    while (current) {
-        printf("(%d, %d) ", current->key, current->value);
-        current = current->next;
+    for (uint32_t n = cache->head; n != NIL; n = cache->nodes[n].next) {
+        printf("(%d, %d) ", cache->nodes[n].key, cache->nodes[n].value);
     }
     printf("\n");
 }
 
 // Free the entire cache
 void freeCache(LRUCache *cache) {
-    Node *current = cache->head;
-    while (current) {
-        Node *temp = current;
-        current = current->next;
-        free(temp);
-    }
+    free(cache->nodes);
+    free(cache->index);
     free(cache);
 }
 
 // Main function to demonstrate the LRU Cache
+#ifndef LRU_NO_MAIN
 int main() {
     LRUCache *cache = initCache(3);
+    if (!cache) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
 
     put(cache, 1, 100);
     put(cache, 2, 200);
@@ -176,6 +265,16 @@ int main() {
     get(cache, 1); // Access key 1 (which is no longer in the cache)
     printCache(cache);
 
+    put(cache, 6, 600); // Keys 1 and 6 both map to slot 1 with `key % 5`; both are now kept
+    put(cache, 1, 100);
+    printCache(cache);
+
+    resizeCache(cache, 5); // Grow; the existing entries keep their order
+    put(cache, 7, 700);
+    put(cache, 8, 800);
+    printCache(cache);
+
     freeCache(cache);
     return 0;
 }
+#endif
@@ -0,0 +1,470 @@
+/*
+ * LRU cache with a byte budget and variable-size values, built on lru.c.
+ *
+ * - byteCachePut(cache, key, value, length) copies `length` opaque bytes into
+ *   the cache. Instead of a fixed number of entries, the cache has a budget in
+ *   bytes: least recently used entries are evicted until the new value fits.
+ *   A value larger than the whole budget is rejected.
+ * - byteCacheGet returns a pointer to the cached bytes (valid until the next
+ *   put or delete) and marks the entry most recently used.
+ * - Entries are kept in an LRUCache from lru.c; each node's value is a handle
+ *   into a table of value descriptors. The entry count is not fixed, so the
+ *   LRUCache is resized (doubled) when it fills up before the budget does.
+ *
+ * Value storage (slab allocator, as in memcached):
+ * - Values up to SLAB_MAX_CHUNK (8 KB) are stored in chunks of fixed size
+ *   classes, each 1.25x the previous one, so a value wastes at most ~20% of its
+ *   chunk. Chunks are cut from 64 KB pages; a page belongs to one class while
+ *   it has live chunks, and returns to a shared pool when it empties, so memory
+ *   moves between classes as the mix of value sizes changes. Small pages keep
+ *   the memory stranded in partly used pages of each class low.
+ * - The page header sits at the start of each page and pages are aligned to
+ *   their size, so freeing a chunk finds its page by masking the address.
+ * - Larger values get their own mmap of whole OS pages, which munmap returns
+ *   in full, so they leave no fragmentation behind.
+ *
+ * Budget accounting:
+ * - The budget limits the memory actually held for values: every slab page
+ *   (whatever its occupancy) plus the mapped size of large values. Rounding and
+ *   fragmentation therefore count against the budget instead of growing past it.
+ * - A put evicts from the LRU tail until the value can be placed: a slab value
+ *   needs a free chunk in its class, or room for one more page; a large value
+ *   needs room for its mapping.
+ *
+ * byteCacheStats reports the bytes callers stored, the chunk and mapping bytes
+ * allocated for them, the memory held, and bookkeeping overhead (nodes, index
+ * and value table).
+ */
+
+#define _GNU_SOURCE                 // MAP_ANONYMOUS under -std=c11
+#define LRU_NO_MAIN
+#include "lru.c"
+
+#include <stddef.h>
+#include <sys/mman.h>
+
+#define SLAB_PAGE_SIZE (64u << 10)
+#define SLAB_MIN_CHUNK 64
+#define SLAB_MAX_CHUNK (SLAB_PAGE_SIZE / 8)   // At least 8 chunks per page
+#define SLAB_GROWTH 1.25
+#define SLAB_MAX_CLASSES 64
+#define CACHED_EMPTY_PAGES 4                  // Empty pages kept for reuse instead of freed
+#define LARGE_ROUNDING 4096                   // Mapping granularity of large values
+#define INITIAL_ENTRIES 1024
+
+typedef struct FreeChunk {
+    struct FreeChunk *next;
+} FreeChunk;
+
+// Header at the start of every slab page
+typedef struct SlabPage {
+    struct SlabPage *prev, *next;   // Links among the class's pages with free chunks
+    FreeChunk *freeChunks;          // Chunks freed on this page
+    uint32_t live;                  // Chunks in use
+    uint32_t carved;                // Chunks handed out at least once (cut lazily)
+    uint32_t sizeClass;
+} SlabPage;
+
+#define SLAB_HEADER ((sizeof(SlabPage) + 63) & ~(size_t)63)
+
+typedef struct SizeClass {
+    uint32_t chunkSize;
+    uint32_t perPage;
+    SlabPage *partial;              // Pages with at least one free chunk
+} SizeClass;
+
+typedef struct SlabAllocator {
+    SizeClass classes[SLAB_MAX_CLASSES];
+    int classCount;
+    SlabPage *emptyPages;           // Cached empty pages, any class may take them
+    uint32_t emptyCount;
+    size_t pagesHeld;               // Pages allocated from the system, including cached ones
+} SlabAllocator;
+
+// Where an entry's bytes live
+typedef struct ValueRef {
+    void *data;                     // NULL for a free handle
+    uint32_t length;
+    uint32_t sizeClass;             // SLAB_MAX_CLASSES for a large value
+    uint32_t nextFree;              // Free handle list
+} ValueRef;
+
+typedef struct ByteCache {
+    LRUCache *lru;                  // Key -> handle into `values`, in recency order
+    ValueRef *values;
+    uint32_t valueSlots;
+    uint32_t freeValue;
+    SlabAllocator slab;
+    size_t budget;                  // Limit on slab pages + large mappings
+    size_t allocated;               // Chunk sizes + large mappings in use
+    size_t valueBytes;              // Bytes callers stored
+    size_t largeBytes;              // Mapped bytes of large values
+    uint64_t evictions;
+} ByteCache;
+
+typedef struct ByteCacheStats {
+    uint32_t entries;
+    uint64_t evictions;
+    size_t budget;
+    size_t heldBytes;               // Counted against the budget: slabBytes + largeBytes
+    size_t slabBytes;               // Slab pages, including cached empty ones
+    size_t largeBytes;              // Mappings of large values
+    size_t allocatedBytes;          // Chunks and mappings in use
+    size_t valueBytes;              // Sum of value lengths
+    size_t metadataBytes;           // Nodes, index and value table
+} ByteCacheStats;
+
+/* Slab allocator */
+
+static void slabInit(SlabAllocator *slab) {
+    memset(slab, 0, sizeof(*slab));
+    double size = SLAB_MIN_CHUNK;
+    while (slab->classCount < SLAB_MAX_CLASSES) {
+        uint32_t chunk = ((uint32_t)size + 7) & ~7u;   // Keep chunks 8-byte aligned
+        if (chunk > SLAB_MAX_CHUNK) chunk = SLAB_MAX_CHUNK;
+        SizeClass *sc = &slab->classes[slab->classCount++];
+        sc->chunkSize = chunk;
+        sc->perPage = (uint32_t)((SLAB_PAGE_SIZE - SLAB_HEADER) / chunk);
+        sc->partial = NULL;
+        if (chunk == SLAB_MAX_CHUNK) break;
+        size *= SLAB_GROWTH;
+    }
+}
+
+// Smallest class whose chunks hold `length` bytes, or -1 if too large for the slabs
+static int slabClassFor(const SlabAllocator *slab, size_t length) {
+    int lo = 0, hi = slab->classCount;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (slab->classes[mid].chunkSize < length) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < slab->classCount ? lo : -1;
+}
+
+static void pageUnlink(SizeClass *sc, SlabPage *page) {
+    if (page->prev) page->prev->next = page->next;
+    else sc->partial = page->next;
+    if (page->next) page->next->prev = page->prev;
+}
+
+static void pagePush(SizeClass *sc, SlabPage *page) {
+    page->prev = NULL;
+    page->next = sc->partial;
+    if (sc->partial) sc->partial->prev = page;
+    sc->partial = page;
+}
+
+static void *slabAlloc(SlabAllocator *slab, int sizeClass) {
+    SizeClass *sc = &slab->classes[sizeClass];
+    SlabPage *page = sc->partial;
+    if (!page) {
+        if (slab->emptyPages) {
+            page = slab->emptyPages;
+            slab->emptyPages = page->next;
+            slab->emptyCount--;
+        } else {
+            page = (SlabPage *)aligned_alloc(SLAB_PAGE_SIZE, SLAB_PAGE_SIZE);
+            if (!page) return NULL;
+            slab->pagesHeld++;
+        }
+        page->freeChunks = NULL;
+        page->live = page->carved = 0;
+        page->sizeClass = (uint32_t)sizeClass;
+        pagePush(sc, page);
+    }
+
+    void *chunk;
+    if (page->freeChunks) {
+        chunk = page->freeChunks;
+        page->freeChunks = page->freeChunks->next;
+    } else {
+        chunk = (char *)page + SLAB_HEADER + (size_t)page->carved++ * sc->chunkSize;
+    }
+    if (++page->live == sc->perPage) pageUnlink(sc, page);   // Full
+    return chunk;
+}
+
+static void slabFree(SlabAllocator *slab, void *chunk) {
+    SlabPage *page = (SlabPage *)((uintptr_t)chunk & ~(uintptr_t)(SLAB_PAGE_SIZE - 1));
+    SizeClass *sc = &slab->classes[page->sizeClass];
+    FreeChunk *freeChunk = (FreeChunk *)chunk;
+    freeChunk->next = page->freeChunks;
+    page->freeChunks = freeChunk;
+
+    if (page->live-- == sc->perPage) pagePush(sc, page);      // Was full
+    if (page->live == 0) {
+        // Give the page back so any class can use it
+        pageUnlink(sc, page);
+        if (slab->emptyCount < CACHED_EMPTY_PAGES) {
+            page->next = slab->emptyPages;
+            slab->emptyPages = page;
+            slab->emptyCount++;
+        } else {
+            free(page);
+            slab->pagesHeld--;
+        }
+    }
+}
+
+// Free one cached empty page. Returns 0 if there was none.
+static int slabReleaseEmpty(SlabAllocator *slab) {
+    SlabPage *page = slab->emptyPages;
+    if (!page) return 0;
+    slab->emptyPages = page->next;
+    slab->emptyCount--;
+    slab->pagesHeld--;
+    free(page);
+    return 1;
+}
+
+static void slabDestroy(SlabAllocator *slab) {
+    // Pages still in use are freed by the caller walking its values; this frees cached ones
+    while (slab->emptyPages) {
+        SlabPage *next = slab->emptyPages->next;
+        free(slab->emptyPages);
+        slab->emptyPages = next;
+    }
+}
+
+/* Value storage */
+
+// Bytes allocated for a value: its chunk, or its whole mapping
+static size_t allocationFor(const ByteCache *cache, size_t length, int sizeClass) {
+    if (sizeClass >= 0) return cache->slab.classes[sizeClass].chunkSize;
+    return (length + LARGE_ROUNDING - 1) / LARGE_ROUNDING * LARGE_ROUNDING;
+}
+
+static size_t heldBytes(const ByteCache *cache) {
+    return cache->slab.pagesHeld * SLAB_PAGE_SIZE + cache->largeBytes;
+}
+
+static void releaseValue(ByteCache *cache, uint32_t handle) {
+    ValueRef *ref = &cache->values[handle];
+    int sizeClass = ref->sizeClass == SLAB_MAX_CLASSES ? -1 : (int)ref->sizeClass;
+    size_t size = allocationFor(cache, ref->length, sizeClass);
+    if (sizeClass >= 0) {
+        slabFree(&cache->slab, ref->data);
+    } else {
+        munmap(ref->data, size);
+        cache->largeBytes -= size;
+    }
+    cache->allocated -= size;
+    cache->valueBytes -= ref->length;
+    ref->data = NULL;
+    ref->nextFree = cache->freeValue;
+    cache->freeValue = handle;
+}
+
+// Evict the least recently used entry
+static void evictTail(ByteCache *cache) {
+    LRUCache *lru = cache->lru;
+    releaseValue(cache, (uint32_t)lru->nodes[lru->tail].value);
+    removeTail(lru);
+    cache->evictions++;
+}
+
+// Remove an entry (node n) from the LRU list and index
+static void removeEntry(ByteCache *cache, uint32_t n) {
+    LRUCache *lru = cache->lru;
+    releaseValue(cache, (uint32_t)lru->nodes[n].value);
+    detach(lru, n);
+    indexRemove(lru, indexFind(lru, lru->nodes[n].key));
+    lru->nodes[n].next = lru->freeList;
+    lru->freeList = n;
+    lru->size--;
+}
+
+// Evict until a value of this class (or a large value of `size` bytes) can be
+// placed within the budget. Returns -1 if even an empty cache has no room.
+static int makeRoom(ByteCache *cache, int sizeClass, size_t size) {
+    for (;;) {
+        if (sizeClass >= 0) {
+            SlabAllocator *slab = &cache->slab;
+            if (slab->classes[sizeClass].partial || slab->emptyPages) return 0;
+            if (heldBytes(cache) + SLAB_PAGE_SIZE <= cache->budget) return 0;
+        } else {
+            if (heldBytes(cache) + size <= cache->budget) return 0;
+            if (slabReleaseEmpty(&cache->slab)) continue;
+        }
+        if (cache->lru->size == 0) return -1;
+        evictTail(cache);
+    }
+}
+
+// Create a cache that holds at most `budget` bytes of values
+ByteCache *initByteCache(size_t budget) {
+    ByteCache *cache = (ByteCache *)calloc(1, sizeof(ByteCache));
+    if (!cache) return NULL;
+    cache->lru = initCache(INITIAL_ENTRIES);
+    cache->values = (ValueRef *)malloc(INITIAL_ENTRIES * sizeof(ValueRef));
+    if (!cache->lru || !cache->values) {
+        if (cache->lru) freeCache(cache->lru);
+        free(cache->values);
+        free(cache);
+        return NULL;
+    }
+    cache->valueSlots = INITIAL_ENTRIES;
+    for (uint32_t i = 0; i < INITIAL_ENTRIES; i++) {
+        cache->values[i].data = NULL;
+        cache->values[i].nextFree = i + 1 < INITIAL_ENTRIES ? i + 1 : NIL;
+    }
+    cache->freeValue = 0;
+    slabInit(&cache->slab);
+    cache->budget = budget;
+    return cache;
+}
+
+// Double the entry capacity of the LRU and the value table
+static int growEntries(ByteCache *cache) {
+    uint32_t slots = cache->valueSlots * 2;
+    if (resizeCache(cache->lru, slots) != 0) return -1;
+    ValueRef *values = (ValueRef *)realloc(cache->values, slots * sizeof(ValueRef));
+    if (!values) return -1;
+    for (uint32_t i = cache->valueSlots; i < slots; i++) {
+        values[i].data = NULL;
+        values[i].nextFree = i + 1 < slots ? i + 1 : cache->freeValue;
+    }
+    cache->freeValue = cache->valueSlots;
+    cache->values = values;
+    cache->valueSlots = slots;
+    return 0;
+}
+
+// Store a copy of `length` bytes under `key`, evicting until it fits.
+// Returns 0 on success, -1 if the value exceeds the budget or memory runs out.
+// Any previous value of the key is removed, even if the new one cannot be stored.
+int byteCachePut(ByteCache *cache, int key, const void *value, size_t length) {
+    LRUCache *lru = cache->lru;
+    uint32_t slot = indexFind(lru, key);
+    if (slot != NIL) removeEntry(cache, lru->index[slot].node);
+
+    if (length > UINT32_MAX) return -1;
+    int sizeClass = slabClassFor(&cache->slab, length);
+    size_t size = allocationFor(cache, length, sizeClass);
+    if (makeRoom(cache, sizeClass, size) != 0) return -1;
+    if (lru->size == lru->capacity && growEntries(cache) != 0) return -1;
+
+    void *data;
+    if (sizeClass >= 0) {
+        data = slabAlloc(&cache->slab, sizeClass);
+    } else {
+        data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED) data = NULL;
+    }
+    if (!data) return -1;
+    memcpy(data, value, length);
+
+    uint32_t handle = cache->freeValue;
+    ValueRef *ref = &cache->values[handle];
+    cache->freeValue = ref->nextFree;
+    ref->data = data;
+    ref->length = (uint32_t)length;
+    ref->sizeClass = sizeClass >= 0 ? (uint32_t)sizeClass : SLAB_MAX_CLASSES;
+
+    cache->allocated += size;
+    cache->valueBytes += length;
+    if (sizeClass < 0) cache->largeBytes += size;
+    put(lru, key, (int)handle);
+    return 0;
+}
+
+// Get the bytes stored under `key`, or NULL. The pointer is valid until the
+// next put or delete.
+const void *byteCacheGet(ByteCache *cache, int key, size_t *length) {
+    int handle = get(cache->lru, key);
+    if (handle == -1) return NULL;
+    if (length) *length = cache->values[handle].length;
+    return cache->values[handle].data;
+}
+
+// Remove a key. Returns 1 if it was present.
+int byteCacheDelete(ByteCache *cache, int key) {
+    uint32_t slot = indexFind(cache->lru, key);
+    if (slot == NIL) return 0;
+    removeEntry(cache, cache->lru->index[slot].node);
+    return 1;
+}
+
+void byteCacheStats(const ByteCache *cache, ByteCacheStats *stats) {
+    const LRUCache *lru = cache->lru;
+    stats->entries = lru->size;
+    stats->evictions = cache->evictions;
+    stats->budget = cache->budget;
+    stats->heldBytes = heldBytes(cache);
+    stats->slabBytes = cache->slab.pagesHeld * SLAB_PAGE_SIZE;
+    stats->largeBytes = cache->largeBytes;
+    stats->allocatedBytes = cache->allocated;
+    stats->valueBytes = cache->valueBytes;
+    stats->metadataBytes = (size_t)lru->capacity * sizeof(Node) +
+                           ((size_t)lru->indexMask + 1) * sizeof(IndexSlot) +
+                           (size_t)cache->valueSlots * sizeof(ValueRef) + sizeof(ByteCache);
+}
+
+void freeByteCache(ByteCache *cache) {
+    while (cache->lru->size > 0) evictTail(cache);
+    slabDestroy(&cache->slab);
+    freeCache(cache->lru);
+    free(cache->values);
+    free(cache);
+}
+
+static void printStats(const ByteCache *cache) {
+    ByteCacheStats s;
+    byteCacheStats(cache, &s);
+    printf("entries %u, evictions %llu\n", s.entries, (unsigned long long)s.evictions);
+    printf("  budget %zu, held %zu (slab pages %zu, large values %zu)\n", s.budget, s.heldBytes, s.slabBytes,
+           s.largeBytes);
+    printf("  values %zu = %.1f%% of held, %.1f%% of allocated chunks and mappings\n", s.valueBytes,
+           s.heldBytes ? 100.0 * s.valueBytes / s.heldBytes : 0,
+           s.allocatedBytes ? 100.0 * s.valueBytes / s.allocatedBytes : 0);
+    printf("  metadata %zu (%.1f bytes/entry)\n", s.metadataBytes,
+           s.entries ? (double)s.metadataBytes / s.entries : 0);
+}
+
+// Main function to demonstrate the byte-budgeted cache with query results of
+// 100 B to 2 MB
+int main() {
+    ByteCache *cache = initByteCache(64u << 20);   // 64 MB
+    if (!cache) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    static char buffer[2u << 20];
+    memset(buffer, 'x', sizeof(buffer));
+    unsigned int seed = 7;
+    long hits = 0, requests = 0;
+
+    for (int i = 0; i < 200000; i++) {
+        int key = rand_r(&seed) % 20000;
+        // Result size depends on the query: mostly small, a few very large
+        // (100 B to 2 MB, about 100 * 20000^(u^6); 2^14.3 is about 20000)
+        double u = (hashKey(key) % 10000) / 10000.0;
+        double doublings = 14.3 * u * u * u * u * u * u;
+        int whole = (int)doublings;
+        size_t length = (size_t)((100u << whole) * (1.0 + (doublings - whole)));
+        if (length > 2000000) length = 2000000;
+
+        size_t cachedLength;
+        requests++;
+        if (byteCacheGet(cache, key, &cachedLength)) {
+            hits++;
+        } else {
+            byteCachePut(cache, key, buffer, length);
+        }
+        if (heldBytes(cache) > cache->budget) {
+            printf("Budget exceeded\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("Hit ratio %.3f\n", (double)hits / requests);
+    printStats(cache);
+
+    int stored = byteCachePut(cache, -1, buffer, sizeof(buffer)) == 0 && byteCachePut(cache, -2, buffer, 0) == 0;
+    printf("2 MB and empty values stored: %s\n", stored ? "yes" : "no");
+
+    freeByteCache(cache);
+    return 0;
+}
@@ -0,0 +1,373 @@
+/*
+ * Thread-safe cache for many concurrent readers, approximating LRU with CLOCK.
+ *
+ * - `get` in lru.c moves the node to the head, so every hit writes the shared
+ *   list and a thread-safe version of it needs a global lock even for reads.
+ *   Here a hit does not reorder anything: it only sets the entry's reference
+ *   bit (one relaxed store, skipped if the bit is already set).
+ * - The cache is split into shards by key hash. Each shard has its own mutex
+ *   for writers, its own entry array and index, and its own clock hand, so
+ *   writers to different shards never contend.
+ * - Readers take no lock. Each shard has a sequence counter (seqlock): a
+ *   writer makes it odd while it changes the shard and even again when it is
+ *   done, and a reader retries if the counter was odd or changed while it was
+ *   reading. Readers therefore never write to the shard's shared cache lines,
+ *   which is what lets hit throughput grow with the number of threads.
+ * - Eviction (second chance): the shard's entries form a circle. When the
+ *   shard is full, the clock hand sweeps it; an entry with its reference bit
+ *   set gets the bit cleared and is skipped, and the first entry without it is
+ *   replaced. Recently read entries survive one more sweep, which tracks LRU
+ *   closely in hit ratio.
+ * - The shard index is the same open-addressing table as in lru.c (key and
+ *   entry number per slot, backward-shift deletion), with the slot packed
+ *   into one 64-bit word so a reader loads it atomically.
+ *
+ * The example below compares the hit ratio with the exact LRUCache from lru.c
+ * and measures hit throughput with 1 to 32 threads.
+ */
+
+#define LRU_NO_MAIN
+#include "lru.c"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#define CACHE_LINE 64
+
+// One cached entry; the entry's position in the shard array is its place on the clock
+typedef struct ClockEntry {
+    _Atomic int key;
+    _Atomic int value;
+    _Atomic unsigned char referenced;
+} ClockEntry;
+
+typedef struct Shard {
+    _Alignas(CACHE_LINE) _Atomic uint32_t seq;  // Odd while a writer is changing the shard
+    pthread_mutex_t writeLock;                  // Serializes writers only
+    uint32_t capacity;
+    uint32_t size;
+    uint32_t hand;                              // Next entry the clock looks at
+    uint32_t indexMask;
+    ClockEntry *entries;
+    _Atomic uint64_t *index;                    // (key << 32) | entry, or EMPTY_SLOT
+} Shard;
+
+typedef struct ConcurrentLRUCache {
+    uint32_t shardMask;
+    Shard *shards;
+} ConcurrentLRUCache;
+
+#define EMPTY_SLOT ((uint64_t)NIL)
+
+static uint64_t packSlot(int key, uint32_t entry) {
+    return ((uint64_t)(uint32_t)key << 32) | entry;
+}
+
+static int slotKey(uint64_t slot) { return (int)(uint32_t)(slot >> 32); }
+static uint32_t slotEntry(uint64_t slot) { return (uint32_t)slot; }
+
+// Shards are picked with the high bits of the hash, index slots with the low bits
+static Shard *shardFor(const ConcurrentLRUCache *cache, uint32_t hash) {
+    return &cache->shards[(hash >> 24) & cache->shardMask];
+}
+
+// Create a cache holding about `capacity` entries split over `shardsHint`
+// shards (rounded up to a power of two). Returns NULL if out of memory.
+ConcurrentLRUCache *initConcurrentCache(uint32_t capacity, uint32_t shardsHint) {
+    uint32_t shards = 1;
+    while (shards < shardsHint && shards < 256 && shards * 2 <= capacity) shards *= 2;
+    uint32_t perShard = (capacity + shards - 1) / shards;
+    if (perShard == 0 || perShard >= NIL / 2) return NULL;
+
+    ConcurrentLRUCache *cache = (ConcurrentLRUCache *)malloc(sizeof(ConcurrentLRUCache));
+    if (!cache) return NULL;
+    cache->shardMask = shards - 1;
+    cache->shards = (Shard *)aligned_alloc(CACHE_LINE, shards * sizeof(Shard));
+    if (!cache->shards) {
+        free(cache);
+        return NULL;
+    }
+
+    uint32_t slots = 2;
+    while (slots < 2 * (uint64_t)perShard) slots *= 2;
+    for (uint32_t i = 0; i < shards; i++) {
+        Shard *shard = &cache->shards[i];
+        atomic_init(&shard->seq, 0);
+        pthread_mutex_init(&shard->writeLock, NULL);
+        shard->capacity = perShard;
+        shard->size = 0;
+        shard->hand = 0;
+        shard->indexMask = slots - 1;
+        shard->entries = (ClockEntry *)calloc(perShard, sizeof(ClockEntry));
+        shard->index = (_Atomic uint64_t *)malloc(slots * sizeof(uint64_t));
+        if (!shard->entries || !shard->index) {
+            // Free what has been set up so far, including this shard
+            for (uint32_t j = 0; j <= i; j++) {
+                free(cache->shards[j].entries);
+                free(cache->shards[j].index);
+            }
+            free(cache->shards);
+            free(cache);
+            return NULL;
+        }
+        for (uint32_t s = 0; s < slots; s++) atomic_init(&shard->index[s], EMPTY_SLOT);
+    }
+    return cache;
+}
+
+// Index slot holding `key`, or NIL. Readers may see a shard mid-update, so the
+// probe is bounded and the caller validates the result with the sequence counter.
+static uint32_t shardFind(const Shard *shard, uint32_t hash, int key) {
+    uint32_t mask = shard->indexMask;
+    uint32_t slot = hash & mask;
+    for (uint32_t n = 0; n <= mask; n++, slot = (slot + 1) & mask) {
+        uint64_t s = atomic_load_explicit(&shard->index[slot], memory_order_relaxed);
+        if (s == EMPTY_SLOT) break;
+        if (slotKey(s) == key) return slot;
+    }
+    return NIL;
+}
+
+// Look up a key. Returns 1 and stores the value if found, 0 otherwise. Takes no lock.
+int concurrentGet(ConcurrentLRUCache *cache, int key, int *value) {
+    uint32_t hash = hashKey(key);
+    Shard *shard = shardFor(cache, hash);
+
+    for (;;) {
+        uint32_t before = atomic_load_explicit(&shard->seq, memory_order_acquire);
+        if (before & 1) continue;  // A writer is in the middle of an update
+
+        uint32_t slot = shardFind(shard, hash, key);
+        uint32_t entry = NIL;
+        int found = 0;
+        if (slot != NIL) {
+            entry = slotEntry(atomic_load_explicit(&shard->index[slot], memory_order_relaxed));
+            if (entry < shard->capacity) {
+                found = atomic_load_explicit(&shard->entries[entry].value, memory_order_relaxed);
+            }
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&shard->seq, memory_order_relaxed) != before) continue;
+
+        if (slot == NIL) return 0;
+        *value = found;
+        // Second chance: mark the entry as used. Only write if needed, so hot
+        // entries keep their cache line shared between readers.
+        ClockEntry *e = &shard->entries[entry];
+        if (!atomic_load_explicit(&e->referenced, memory_order_relaxed)) {
+            atomic_store_explicit(&e->referenced, 1, memory_order_relaxed);
+        }
+        return 1;
+    }
+}
+
+static void beginWrite(Shard *shard) {
+    uint32_t seq = atomic_load_explicit(&shard->seq, memory_order_relaxed);
+    atomic_store_explicit(&shard->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static void endWrite(Shard *shard) {
+    uint32_t seq = atomic_load_explicit(&shard->seq, memory_order_relaxed);
+    atomic_store_explicit(&shard->seq, seq + 1, memory_order_release);
+}
+
+// Empty an index slot with backward-shift deletion (as indexRemove in lru.c)
+static void shardIndexRemove(Shard *shard, uint32_t slot) {
+    uint32_t mask = shard->indexMask;
+    uint32_t hole = slot;
+    for (uint32_t next = (hole + 1) & mask;; next = (next + 1) & mask) {
+        uint64_t s = atomic_load_explicit(&shard->index[next], memory_order_relaxed);
+        if (s == EMPTY_SLOT) break;
+        uint32_t home = hashKey(slotKey(s)) & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            atomic_store_explicit(&shard->index[hole], s, memory_order_relaxed);
+            hole = next;
+        }
+    }
+    atomic_store_explicit(&shard->index[hole], EMPTY_SLOT, memory_order_relaxed);
+}
+
+static void shardIndexInsert(Shard *shard, uint32_t hash, int key, uint32_t entry) {
+    uint32_t slot = hash & shard->indexMask;
+    while (atomic_load_explicit(&shard->index[slot], memory_order_relaxed) != EMPTY_SLOT) {
+        slot = (slot + 1) & shard->indexMask;
+    }
+    atomic_store_explicit(&shard->index[slot], packSlot(key, entry), memory_order_relaxed);
+}
+
+// Pick the entry to reuse: sweep the clock hand, giving referenced entries a second chance
+static uint32_t clockEvict(Shard *shard) {
+    for (;;) {
+        uint32_t victim = shard->hand;
+        shard->hand = shard->hand + 1 == shard->capacity ? 0 : shard->hand + 1;
+        ClockEntry *e = &shard->entries[victim];
+        if (atomic_load_explicit(&e->referenced, memory_order_relaxed)) {
+            atomic_store_explicit(&e->referenced, 0, memory_order_relaxed);
+            continue;
+        }
+        int key = atomic_load_explicit(&e->key, memory_order_relaxed);
+        shardIndexRemove(shard, shardFind(shard, hashKey(key), key));
+        return victim;
+    }
+}
+
+// Insert or update a key-value pair
+void concurrentPut(ConcurrentLRUCache *cache, int key, int value) {
+    uint32_t hash = hashKey(key);
+    Shard *shard = shardFor(cache, hash);
+
+    pthread_mutex_lock(&shard->writeLock);
+    uint32_t slot = shardFind(shard, hash, key);
+    if (slot != NIL) {
+        // A single atomic store; readers see the old or the new value
+        ClockEntry *e = &shard->entries[slotEntry(atomic_load_explicit(&shard->index[slot], memory_order_relaxed))];
+        atomic_store_explicit(&e->value, value, memory_order_relaxed);
+        atomic_store_explicit(&e->referenced, 1, memory_order_relaxed);
+        pthread_mutex_unlock(&shard->writeLock);
+        return;
+    }
+
+    beginWrite(shard);
+    uint32_t entry = shard->size < shard->capacity ? shard->size++ : clockEvict(shard);
+    ClockEntry *e = &shard->entries[entry];
+    atomic_store_explicit(&e->key, key, memory_order_relaxed);
+    atomic_store_explicit(&e->value, value, memory_order_relaxed);
+    atomic_store_explicit(&e->referenced, 0, memory_order_relaxed);  // New entries must be read to earn a second chance
+    shardIndexInsert(shard, hash, key, entry);
+    endWrite(shard);
+    pthread_mutex_unlock(&shard->writeLock);
+}
+
+// Remove a key. Returns 1 if it was present.
+int concurrentRemove(ConcurrentLRUCache *cache, int key) {
+    uint32_t hash = hashKey(key);
+    Shard *shard = shardFor(cache, hash);
+
+    pthread_mutex_lock(&shard->writeLock);
+    uint32_t slot = shardFind(shard, hash, key);
+    if (slot != NIL) {
+        beginWrite(shard);
+        uint32_t entry = slotEntry(atomic_load_explicit(&shard->index[slot], memory_order_relaxed));
+        shardIndexRemove(shard, slot);
+        // Keep the entries dense: move the last entry into the freed position
+        uint32_t last = --shard->size;
+        if (entry != last) {
+            ClockEntry *from = &shard->entries[last], *to = &shard->entries[entry];
+            int movedKey = atomic_load_explicit(&from->key, memory_order_relaxed);
+            atomic_store_explicit(&to->key, movedKey, memory_order_relaxed);
+            atomic_store_explicit(&to->value, atomic_load_explicit(&from->value, memory_order_relaxed),
+                                  memory_order_relaxed);
+            atomic_store_explicit(&to->referenced, atomic_load_explicit(&from->referenced, memory_order_relaxed),
+                                  memory_order_relaxed);
+            uint32_t movedHash = hashKey(movedKey);
+            atomic_store_explicit(&shard->index[shardFind(shard, movedHash, movedKey)], packSlot(movedKey, entry),
+                                  memory_order_relaxed);
+        }
+        if (shard->hand >= shard->size) shard->hand = 0;
+        endWrite(shard);
+    }
+    pthread_mutex_unlock(&shard->writeLock);
+    return slot != NIL;
+}
+
+// Free the cache; no thread may be using it any more
+void freeConcurrentCache(ConcurrentLRUCache *cache) {
+    for (uint32_t i = 0; i <= cache->shardMask; i++) {
+        pthread_mutex_destroy(&cache->shards[i].writeLock);
+        free(cache->shards[i].entries);
+        free(cache->shards[i].index);
+    }
+    free(cache->shards);
+    free(cache);
+}
+
+// Example usage
+
+#define CACHE_CAPACITY (1 << 16)
+#define KEY_SPACE (1 << 18)
+#define TRACE_LENGTH 2000000
+#define OPS_PER_THREAD 2000000
+
+// Skewed keys: a few keys are hot, most are cold (roughly Zipfian)
+static int skewedKey(uint64_t *state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    double u = (double)(*state >> 11) / 9007199254740992.0;
+    return (int)(KEY_SPACE * u * u * u);
+}
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Replay the same read-through trace against exact LRU and the CLOCK cache
+static void compareHitRatio(void) {
+    LRUCache *exact = initCache(CACHE_CAPACITY);
+    ConcurrentLRUCache *clock = initConcurrentCache(CACHE_CAPACITY, 64);
+    uint64_t state = 42;
+    long exactHits = 0, clockHits = 0;
+
+    for (int i = 0; i < TRACE_LENGTH; i++) {
+        int key = skewedKey(&state), value;
+        if (get(exact, key) != -1) exactHits++;
+        else put(exact, key, key);
+        if (concurrentGet(clock, key, &value)) clockHits++;
+        else concurrentPut(clock, key, key);
+    }
+    printf("Hit ratio: exact LRU %.4f, sharded CLOCK %.4f\n",
+           (double)exactHits / TRACE_LENGTH, (double)clockHits / TRACE_LENGTH);
+    freeCache(exact);
+    freeConcurrentCache(clock);
+}
+
+typedef struct ReaderArgs {
+    ConcurrentLRUCache *cache;
+    uint64_t seed;
+    long hits;
+} ReaderArgs;
+
+void *readerThread(void *arg) {
+    ReaderArgs *args = (ReaderArgs *)arg;
+    uint64_t state = args->seed;
+    int value;
+    for (int i = 0; i < OPS_PER_THREAD; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        args->hits += concurrentGet(args->cache, (int)((state >> 33) % CACHE_CAPACITY), &value);
+    }
+    return NULL;
+}
+
+int main() {
+    compareHitRatio();
+
+    // Fill with keys 0..CACHE_CAPACITY-1 and measure hits only
+    ConcurrentLRUCache *cache = initConcurrentCache(CACHE_CAPACITY * 2, 64);
+    for (int key = 0; key < CACHE_CAPACITY; key++) {
+        concurrentPut(cache, key, key);
+    }
+
+    for (int threads = 1; threads <= 32; threads *= 2) {
+        pthread_t ids[32];
+        ReaderArgs args[32];
+        double start = nowSeconds();
+        for (int i = 0; i < threads; i++) {
+            args[i] = (ReaderArgs){cache, (uint64_t)i + 1, 0};
+            pthread_create(&ids[i], NULL, readerThread, &args[i]);
+        }
+        long hits = 0;
+        for (int i = 0; i < threads; i++) {
+            pthread_join(ids[i], NULL);
+            hits += args[i].hits;
+        }
+        double seconds = nowSeconds() - start;
+        printf("%2d threads: %7.1f M hits/s (%ld hits)\n", threads,
+               (double)threads * OPS_PER_THREAD / seconds / 1e6, hits);
+    }
+
+    freeConcurrentCache(cache);
+    return 0;
+}
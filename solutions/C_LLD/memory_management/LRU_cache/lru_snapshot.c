@@ -0,0 +1,347 @@
+/*
+ * Warm restart for the LRUCache in lru.c: dump the entries to a file and load
+ * them back, so a restarted process starts with the cache it had.
+ *
+ * File format:
+ * - A 32-byte header (magic, version, capacity, entry count, checksum) and
+ *   then one 8-byte (key, value) record per entry, from the most to the least
+ *   recently used. Nothing else is stored: links and the index are rebuilt.
+ *
+ * Dumping:
+ * - dumpCache(cache, path) walks the list from head to tail and streams the
+ *   records through a fixed buffer. It writes to "path.tmp" and renames it over
+ *   `path` when complete, so a crash mid-dump never leaves a torn snapshot.
+ * - dumpCacheInBackground(cache, path) forks. The child sees a copy-on-write
+ *   image of the cache frozen at the moment of the fork and dumps it, while the
+ *   parent goes on serving gets and puts; only the pages the parent writes to
+ *   are copied. The parent collects the result with finishDump. The child
+ *   does not call malloc, so this is safe in a multi-threaded parent.
+ *
+ * Loading:
+ * - loadCache(path, capacity) reads the records in large sequential chunks.
+ *   Since they come in recency order, record i becomes node i, linked to nodes
+ *   i - 1 and i + 1, so the list is rebuilt with sequential writes only.
+ * - The index inserts are the only random accesses. They are done in batches:
+ *   the home slots of a batch are hashed and prefetched first, so the cache
+ *   misses of a batch overlap instead of being paid one after another.
+ * - If `capacity` is smaller than the snapshot, only the most recently used
+ *   entries are loaded. A bad magic, version, size or checksum fails the load.
+ */
+
+#define _GNU_SOURCE                 // pwrite and posix_fadvise under -std=c11
+#define LRU_NO_MAIN
+#include "lru.c"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SNAPSHOT_MAGIC "LRUSNAP\0"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BUFFER 8192        // Records per write or read (64 KB)
+#define LOAD_BATCH 32               // Index inserts prefetched together
+
+typedef struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t capacity;              // Of the dumped cache
+    uint32_t count;                 // Records that follow
+    uint32_t reserved;
+    uint64_t checksum;              // Of all records, see checksumRecords
+} SnapshotHeader;
+
+typedef struct Record {
+    int key;
+    int value;
+} Record;
+
+// Order-dependent checksum of a run of records, continued from `h`
+static uint64_t checksumRecords(uint64_t h, const Record *records, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t word = (uint64_t)(uint32_t)records[i].key << 32 | (uint32_t)records[i].value;
+        h = (h ^ word) * 0x9e3779b97f4a7c15ull;
+        h ^= h >> 29;
+    }
+    return h;
+}
+
+static int writeAll(int fd, const void *data, size_t length) {
+    const char *p = (const char *)data;
+    while (length > 0) {
+        ssize_t n = write(fd, p, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+// Read exactly `length` bytes; fails on a short file
+static int readAll(int fd, void *data, size_t length) {
+    char *p = (char *)data;
+    while (length > 0) {
+        ssize_t n = read(fd, p, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+// Write every entry, most recently used first, to `path`.
+// Returns 0 on success, -1 on an I/O error (`path` is then left untouched).
+int dumpCache(const LRUCache *cache, const char *path) {
+    char tmpPath[4096];
+    if ((size_t)snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path) >= sizeof(tmpPath)) return -1;
+    int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.capacity = cache->capacity;
+    header.count = cache->size;
+    int failed = writeAll(fd, &header, sizeof(header));
+
+    // On the stack rather than malloc'd, so a forked child can run this
+    Record buffer[SNAPSHOT_BUFFER];
+    uint32_t buffered = 0;
+    uint64_t checksum = 0;
+    for (uint32_t n = cache->head; n != NIL && !failed; n = cache->nodes[n].next) {
+        buffer[buffered].key = cache->nodes[n].key;
+        buffer[buffered].value = cache->nodes[n].value;
+        if (++buffered == SNAPSHOT_BUFFER) {
+            checksum = checksumRecords(checksum, buffer, buffered);
+            failed = writeAll(fd, buffer, sizeof(buffer));
+            buffered = 0;
+        }
+    }
+    if (!failed && buffered > 0) {
+        checksum = checksumRecords(checksum, buffer, buffered);
+        failed = writeAll(fd, buffer, buffered * sizeof(Record));
+    }
+
+    // The checksum is only known at the end; patch it into the header
+    header.checksum = checksum;
+    if (!failed) failed = pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header);
+    if (close(fd) != 0) failed = 1;
+    if (!failed) failed = rename(tmpPath, path) != 0;
+    if (failed) {
+        unlink(tmpPath);
+        return -1;
+    }
+    return 0;
+}
+
+// Start dumping the cache as it is now in a forked child, and return at once.
+// The caller keeps using the cache and later calls finishDump with the returned
+// pid. Returns -1 if the fork fails.
+pid_t dumpCacheInBackground(const LRUCache *cache, const char *path) {
+    pid_t pid = fork();
+    if (pid == 0) _exit(dumpCache(cache, path) == 0 ? 0 : 1);
+    return pid;
+}
+
+// Collect a background dump. Returns 0 if the snapshot was written, -1 if it
+// failed, and 1 if `block` is 0 and the dump is still running.
+int finishDump(pid_t pid, int block) {
+    int status;
+    pid_t done;
+    while ((done = waitpid(pid, &status, block ? 0 : WNOHANG)) < 0) {
+        if (errno != EINTR) return -1;
+    }
+    if (done == 0) return 1;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+// Index a run of new nodes first..first+count-1, prefetching their home slots a
+// batch at a time. Returns -1 if a key is already indexed.
+static int indexNodes(LRUCache *cache, uint32_t first, uint32_t count) {
+    uint32_t homes[LOAD_BATCH];
+    for (uint32_t i = 0; i < count; i += LOAD_BATCH) {
+        uint32_t batch = count - i < LOAD_BATCH ? count - i : LOAD_BATCH;
+        for (uint32_t j = 0; j < batch; j++) {
+            homes[j] = hashKey(cache->nodes[first + i + j].key) & cache->indexMask;
+            __builtin_prefetch(&cache->index[homes[j]], 1);
+        }
+        for (uint32_t j = 0; j < batch; j++) {
+            int key = cache->nodes[first + i + j].key;
+            uint32_t slot = homes[j];
+            while (cache->index[slot].node != NIL) {
+                if (cache->index[slot].key == key) return -1;
+                slot = (slot + 1) & cache->indexMask;
+            }
+            cache->index[slot].key = key;
+            cache->index[slot].node = first + i + j;
+        }
+    }
+    return 0;
+}
+
+// Create a cache from a snapshot. `capacity` 0 means the capacity the cache
+// had when it was dumped; a smaller one keeps the most recently used entries.
+// Returns NULL if the file is missing or corrupt, or if out of memory.
+LRUCache *loadCache(const char *path, uint32_t capacity) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    SnapshotHeader header;
+    struct stat st;
+    if (readAll(fd, &header, sizeof(header)) != 0 || fstat(fd, &st) != 0 ||
+        memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SNAPSHOT_VERSION || header.count > header.capacity ||
+        (uint64_t)st.st_size != sizeof(header) + (uint64_t)header.count * sizeof(Record)) {
+        close(fd);
+        return NULL;
+    }
+
+    if (capacity == 0) capacity = header.capacity;
+    LRUCache *cache = initCache(capacity);
+    if (!cache) {
+        close(fd);
+        return NULL;
+    }
+    uint32_t keep = header.count < capacity ? header.count : capacity;
+
+    Record buffer[SNAPSHOT_BUFFER];
+    uint64_t checksum = 0;
+    int failed = 0;
+    for (uint32_t done = 0; done < header.count && !failed;) {
+        uint32_t chunk = header.count - done < SNAPSHOT_BUFFER ? header.count - done : SNAPSHOT_BUFFER;
+        if (readAll(fd, buffer, chunk * sizeof(Record)) != 0) {
+            failed = 1;
+            break;
+        }
+        checksum = checksumRecords(checksum, buffer, chunk);
+
+        // Record i of the file becomes node i, between nodes i - 1 and i + 1
+        uint32_t used = done < keep ? (keep - done < chunk ? keep - done : chunk) : 0;
+        for (uint32_t j = 0; j < used; j++) {
+            Node *node = &cache->nodes[done + j];
+            node->key = buffer[j].key;
+            node->value = buffer[j].value;
+            node->prev = done + j - 1;              // NIL for node 0
+            node->next = done + j + 1;
+        }
+        if (indexNodes(cache, done, used) != 0) failed = 1;   // Duplicate key
+        done += chunk;
+    }
+    close(fd);
+
+    if (failed || checksum != header.checksum) {
+        freeCache(cache);
+        return NULL;
+    }
+
+    if (keep > 0) {
+        cache->head = 0;
+        cache->tail = keep - 1;
+        cache->nodes[keep - 1].next = NIL;
+    }
+    cache->size = keep;
+    cache->freeList = keep < capacity ? keep : NIL;   // allocStorage chained the rest
+    return cache;
+}
+
+// Example usage: fill a large cache, dump it in the foreground and in the
+// background while it keeps serving writes, then load it back and compare
+static double secondsSince(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static uint64_t nextRandom(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static int sameContents(const LRUCache *a, const LRUCache *b) {
+    if (a->size != b->size) return 0;
+    uint32_t m = b->head;
+    for (uint32_t n = a->head; n != NIL; n = a->nodes[n].next, m = b->nodes[m].next) {
+        if (a->nodes[n].key != b->nodes[m].key || a->nodes[n].value != b->nodes[m].value) return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t capacity = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 10000000;
+    const char *path = argc > 2 ? argv[2] : "/tmp/lru_snapshot.bin";
+
+    LRUCache *cache = initCache(capacity);
+    if (!cache) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    // Twice as many random keys as entries, so the recency order is shuffled
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t rng = 42;
+    for (uint64_t i = 0; i < 2 * (uint64_t)capacity; i++) {
+        int key = (int)(nextRandom(&rng) % (4 * (uint64_t)capacity));
+        put(cache, key, (int)i);
+    }
+    printf("filled %u entries in %.2f s\n", cache->size, secondsSince(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (dumpCache(cache, path) != 0) {
+        perror("dump");
+        return EXIT_FAILURE;
+    }
+    printf("dump:            %.3f s (%.1f MB)\n", secondsSince(&start),
+           (sizeof(SnapshotHeader) + (double)cache->size * sizeof(Record)) / 1e6);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    LRUCache *loaded = loadCache(path, 0);
+    double loadSeconds = secondsSince(&start);
+    printf("load:            %.3f s, contents %s\n", loadSeconds,
+           loaded && sameContents(cache, loaded) ? "match" : "DIFFER");
+    if (loaded) freeCache(loaded);
+
+    // Background dump: the parent keeps writing while the child dumps the
+    // copy-on-write image taken at the fork
+    LRUCache *expected = loadCache(path, 0);   // The state at the fork
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pid_t pid = dumpCacheInBackground(cache, path);
+    if (pid < 0) {
+        perror("fork");
+        return EXIT_FAILURE;
+    }
+    double forkSeconds = secondsSince(&start);
+    uint64_t writes = 0;
+    int status;
+    while ((status = finishDump(pid, 0)) == 1) {
+        for (int i = 0; i < 1000; i++, writes++) {
+            put(cache, (int)(nextRandom(&rng) % (4 * (uint64_t)capacity)), -1);
+        }
+    }
+    double dumpSeconds = secondsSince(&start);
+    loaded = status == 0 ? loadCache(path, 0) : NULL;
+    printf("background dump: %.3f s (fork %.3f s), %llu puts served meanwhile, snapshot %s\n",
+           dumpSeconds, forkSeconds, (unsigned long long)writes,
+           loaded && expected && sameContents(expected, loaded) ? "matches the fork" : "DIFFERS");
+
+    LRUCache *half = loadCache(path, capacity / 2);
+    printf("load into half capacity keeps %u most recent entries\n", half ? half->size : 0);
+
+    if (loaded) freeCache(loaded);
+    if (expected) freeCache(expected);
+    if (half) freeCache(half);
+    freeCache(cache);
+    unlink(path);
+    return 0;
+}
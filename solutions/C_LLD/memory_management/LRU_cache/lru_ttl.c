@@ -0,0 +1,230 @@
+/*
+ * LRU cache with per-entry time to live (TTL), built on the LRUCache in lru.c.
+ *
+ * - putWithTTL(cache, key, value, ttlMs) stores an entry that expires ttlMs
+ *   milliseconds later; ttlPut stores one that never expires. Both evict the
+ *   least recently used entry when the cache is full, as put does.
+ * - Lazy expiry: ttlGet treats an expired entry as a miss and removes it, so a
+ *   caller never sees a stale value.
+ * - Proactive expiry with a hashed timing wheel: time is cut into ticks of
+ *   `resolutionMs`, and WHEEL_SLOTS slots each hold a list of the entries whose
+ *   expiry falls in a tick that maps to that slot (tick % WHEEL_SLOTS). Each
+ *   write advances the wheel by at most a couple of ticks and removes the
+ *   expired entries of those slots; entries due in a later revolution stay put.
+ *   Work is proportional to the number of entries in the visited slots, never
+ *   to the size of the cache, so there is no full scan.
+ * - There is no timer thread. The wheel only moves inside calls that already
+ *   own the cache (writes, and expireEntries), and after an idle period it
+ *   catches up in one call instead of being woken every tick. A program that
+ *   wants memory back while idle calls expireEntries from its own maintenance
+ *   loop, as often as it likes.
+ * - Expiry times and wheel links live in arrays parallel to the LRU's node
+ *   array, indexed by node number, so the LRUCache itself is unchanged.
+ */
+
+#define LRU_NO_MAIN
+#include "lru.c"
+
+#include <time.h>
+
+#define WHEEL_SLOTS 256              // Power of two
+#define NO_EXPIRY 0
+#define TICKS_PER_WRITE 2            // Wheel ticks a write may advance
+
+typedef struct TTLCache {
+    LRUCache *lru;
+    uint64_t *expiresAt;             // Per node, in ms; NO_EXPIRY if none
+    uint32_t *wheelPrev, *wheelNext; // Per node: links in its wheel slot
+    uint32_t wheel[WHEEL_SLOTS];     // First node of each slot
+    uint64_t resolutionMs;           // Length of one tick
+    uint64_t tick;                   // Every slot up to this tick has been processed
+    uint64_t (*clock)(void);         // Current time in ms
+    uint64_t expired;                // Entries removed because their TTL passed
+} TTLCache;
+
+static uint64_t monotonicMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// Create a cache of `capacity` entries whose wheel ticks every `resolutionMs`.
+// `clock` returns the current time in ms; NULL means CLOCK_MONOTONIC.
+TTLCache *initTTLCache(uint32_t capacity, uint64_t resolutionMs, uint64_t (*clock)(void)) {
+    TTLCache *cache = (TTLCache *)calloc(1, sizeof(TTLCache));
+    if (!cache) return NULL;
+    cache->lru = initCache(capacity);
+    cache->expiresAt = (uint64_t *)calloc(capacity ? capacity : 1, sizeof(uint64_t));
+    cache->wheelPrev = (uint32_t *)malloc((capacity ? capacity : 1) * sizeof(uint32_t));
+    cache->wheelNext = (uint32_t *)malloc((capacity ? capacity : 1) * sizeof(uint32_t));
+    if (!cache->lru || !cache->expiresAt || !cache->wheelPrev || !cache->wheelNext) {
+        if (cache->lru) freeCache(cache->lru);
+        free(cache->expiresAt);
+        free(cache->wheelPrev);
+        free(cache->wheelNext);
+        free(cache);
+        return NULL;
+    }
+    for (int i = 0; i < WHEEL_SLOTS; i++) cache->wheel[i] = NIL;
+    cache->resolutionMs = resolutionMs ? resolutionMs : 1;
+    cache->clock = clock ? clock : monotonicMs;
+    cache->tick = cache->clock() / cache->resolutionMs;
+    return cache;
+}
+
+// Tick whose processing removes an entry expiring at `expiresAt`: the first one
+// that starts after it, which is always later than the wheel's current tick
+static uint64_t expiryTick(const TTLCache *cache, uint64_t expiresAt) {
+    return expiresAt / cache->resolutionMs + 1;
+}
+
+static void wheelLink(TTLCache *cache, uint32_t n) {
+    uint32_t slot = expiryTick(cache, cache->expiresAt[n]) & (WHEEL_SLOTS - 1);
+    cache->wheelPrev[n] = NIL;
+    cache->wheelNext[n] = cache->wheel[slot];
+    if (cache->wheel[slot] != NIL) cache->wheelPrev[cache->wheel[slot]] = n;
+    cache->wheel[slot] = n;
+}
+
+static void wheelUnlink(TTLCache *cache, uint32_t n) {
+    if (cache->expiresAt[n] == NO_EXPIRY) return;
+    uint32_t slot = expiryTick(cache, cache->expiresAt[n]) & (WHEEL_SLOTS - 1);
+    if (cache->wheelPrev[n] != NIL) cache->wheelNext[cache->wheelPrev[n]] = cache->wheelNext[n];
+    else cache->wheel[slot] = cache->wheelNext[n];
+    if (cache->wheelNext[n] != NIL) cache->wheelPrev[cache->wheelNext[n]] = cache->wheelPrev[n];
+    cache->expiresAt[n] = NO_EXPIRY;
+}
+
+// Remove an entry from the wheel, the list and the index
+static void dropEntry(TTLCache *cache, uint32_t n) {
+    LRUCache *lru = cache->lru;
+    wheelUnlink(cache, n);
+    detach(lru, n);
+    indexRemove(lru, indexFind(lru, lru->nodes[n].key));
+    lru->nodes[n].next = lru->freeList;
+    lru->freeList = n;
+    lru->size--;
+}
+
+// Process wheel slots up to the current tick, at most `maxTicks` of them.
+// Returns the number of entries expired.
+static uint32_t advanceWheel(TTLCache *cache, uint64_t now, uint64_t maxTicks) {
+    uint64_t target = now / cache->resolutionMs;
+    uint32_t expired = 0;
+
+    // After a long pause one revolution visits every slot
+    if (target - cache->tick > WHEEL_SLOTS) cache->tick = target - WHEEL_SLOTS;
+
+    for (uint64_t i = 0; i < maxTicks && cache->tick < target; i++) {
+        cache->tick++;
+        uint32_t n = cache->wheel[cache->tick & (WHEEL_SLOTS - 1)];
+        while (n != NIL) {
+            uint32_t next = cache->wheelNext[n];
+            if (cache->expiresAt[n] <= now) {   // Entries of later revolutions stay
+                dropEntry(cache, n);
+                expired++;
+            }
+            n = next;
+        }
+    }
+    cache->expired += expired;
+    return expired;
+}
+
+// Remove every entry that has expired by now. Returns how many were removed.
+uint32_t expireEntries(TTLCache *cache) {
+    return advanceWheel(cache, cache->clock(), WHEEL_SLOTS);
+}
+
+static void storeEntry(TTLCache *cache, int key, int value, uint64_t expiresAt) {
+    LRUCache *lru = cache->lru;
+    if (lru->capacity == 0) return;
+    uint64_t now = cache->clock();
+    advanceWheel(cache, now, TICKS_PER_WRITE);
+
+    uint32_t slot = indexFind(lru, key);
+    if (slot != NIL) {
+        wheelUnlink(cache, lru->index[slot].node);
+    } else if (lru->size == lru->capacity) {
+        wheelUnlink(cache, lru->tail);   // put is about to evict it
+    }
+
+    put(lru, key, value);
+    uint32_t n = lru->head;              // put leaves the entry at the head
+    cache->expiresAt[n] = expiresAt;
+    if (expiresAt != NO_EXPIRY) wheelLink(cache, n);
+}
+
+// Insert or update an entry that never expires
+void ttlPut(TTLCache *cache, int key, int value) {
+    storeEntry(cache, key, value, NO_EXPIRY);
+}
+
+// Insert or update an entry that expires `ttlMs` from now
+void putWithTTL(TTLCache *cache, int key, int value, uint64_t ttlMs) {
+    uint64_t expiresAt = cache->clock() + ttlMs;
+    storeEntry(cache, key, value, expiresAt ? expiresAt : 1);
+}
+
+// Get a value, or -1 if the key is not cached or has expired
+int ttlGet(TTLCache *cache, int key) {
+    LRUCache *lru = cache->lru;
+    uint32_t slot = indexFind(lru, key);
+    if (slot == NIL) return -1;
+
+    uint32_t n = lru->index[slot].node;
+    if (cache->expiresAt[n] != NO_EXPIRY && cache->expiresAt[n] <= cache->clock()) {
+        dropEntry(cache, n);             // Lazy expiry
+        cache->expired++;
+        return -1;
+    }
+    moveToHead(lru, n);
+    return lru->nodes[n].value;
+}
+
+void freeTTLCache(TTLCache *cache) {
+    freeCache(cache->lru);
+    free(cache->expiresAt);
+    free(cache->wheelPrev);
+    free(cache->wheelNext);
+    free(cache);
+}
+
+// Example usage with a simulated clock
+static uint64_t fakeNow = 0;
+
+static uint64_t fakeClock(void) {
+    return fakeNow;
+}
+
+int main() {
+    TTLCache *cache = initTTLCache(4, 100, fakeClock);  // 100 ms ticks
+    if (!cache) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    putWithTTL(cache, 1, 100, 500);    // Expires at 500 ms
+    putWithTTL(cache, 2, 200, 60000);  // Expires in a later revolution of the wheel
+    ttlPut(cache, 3, 300);             // Never expires
+    printCache(cache->lru);
+
+    fakeNow = 400;
+    printf("t=400  get(1) = %d\n", ttlGet(cache, 1));
+
+    fakeNow = 600;
+    printf("t=600  get(1) = %d (expired, removed lazily)\n", ttlGet(cache, 1));
+
+    putWithTTL(cache, 4, 400, 200);    // Expires at 800 ms
+    fakeNow = 1000;
+    printf("t=1000 expired by the wheel: %u\n", expireEntries(cache));
+    printCache(cache->lru);
+
+    fakeNow = 70000;
+    printf("t=70000 expired by the wheel: %u\n", expireEntries(cache));
+    printCache(cache->lru);
+
+    printf("Total expired: %llu\n", (unsigned long long)cache->expired);
+    freeTTLCache(cache);
+    return 0;
+}
@@ -1,5 +1,7 @@
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define MAX_HEAP 1
 #define MIN_HEAP 0
@@ -26,9 +28,21 @@ int parent(int i) { return (i - 1) / 2; }
 int leftChild(int i) { return 2 * i + 1; }
 int rightChild(int i) { return 2 * i + 2; }
 
+// Make room for at least `needed` elements. Returns 0, or -1 if out of memory.
+static int reserveHeap(Heap* heap, int needed) {
+    if (needed <= heap->capacity) return 0;
+    int capacity = heap->capacity > 0 ? heap->capacity : 1;
+    while (capacity < needed) capacity = capacity <= INT_MAX / 2 ? capacity * 2 : needed;
+    int* arr = (int*)realloc(heap->arr, sizeof(int) * capacity);
+    if (!arr) return -1;
+    heap->arr = arr;
+    heap->capacity = capacity;
+    return 0;
+}
+
 // Function to insert an element into the heap
 void insert(Heap* heap, int key) {
-    if (heap->count == heap->capacity) {
+    if (heap->count == heap->capacity && reserveHeap(heap, heap->count + 1) != 0) {
         printf("Heap is full\n");
         return;
     }
@@ -55,30 +69,65 @@ void insert(Heap* heap, int key) {
     }
 }
 
-// Function to heapify down
+// Nonzero if `a` belongs above `b`
+static int higher(const Heap* heap, int a, int b) {
+    return heap->heap_type == MAX_HEAP ? a > b : a < b;
+}
+
+// Function to heapify down: move the element at `i` down until both children
+// are below it. Iterative; the element is held aside and children move up into
+// the hole, so it is written once instead of swapped at every level.
 void heapify(Heap* heap, int i) {
-    int left = leftChild(i);
-    int right = rightChild(i);
-    int extreme = i;
-    
-    if (heap->heap_type == MAX_HEAP) {
-        if (left < heap->count && heap->arr[left] > heap->arr[extreme])
-            extreme = left;
-        if (right < heap->count && heap->arr[right] > heap->arr[extreme])
+    int key = heap->arr[i];
+    for (;;) {
+        int extreme = leftChild(i);
+        if (extreme >= heap->count) break;
+        int right = rightChild(i);
+        if (right < heap->count && higher(heap, heap->arr[right], heap->arr[extreme]))
             extreme = right;
-    } else {  // MIN_HEAP
-        if (left < heap->count && heap->arr[left] < heap->arr[extreme])
-            extreme = left;
-        if (right < heap->count && heap->arr[right] < heap->arr[extreme])
-            extreme = right;
-    }
-    
-    if (extreme != i) {
-        int temp = heap->arr[i];
+        if (!higher(heap, heap->arr[extreme], key)) break;
         heap->arr[i] = heap->arr[extreme];
-        heap->arr[extreme] = temp;
-        heapify(heap, extreme);
+        i = extreme;
+    }
+    heap->arr[i] = key;
+}
+
+// Function to build a heap from an array in O(n) (Floyd): copy the keys, then
+// heapify every node that has children, from the last one up to the root.
+// Most nodes are near the bottom and sift down only a level or two, which is
+// why this beats n separate inserts (O(n log n)). Replaces the heap's contents.
+// Returns 0, or -1 if out of memory.
+int buildHeap(Heap* heap, const int* keys, int n) {
+    if (reserveHeap(heap, n) != 0) return -1;
+    memcpy(heap->arr, keys, sizeof(int) * n);
+    heap->count = n;
+    for (int i = n / 2 - 1; i >= 0; i--)
+        heapify(heap, i);
+    return 0;
+}
+
+// Function to insert many elements at once. Small batches are sifted up one by
+// one; a batch large compared with the heap is appended and the whole heap is
+// rebuilt with Floyd's method, which is cheaper than k sifts once
+// k * log2(n + k) exceeds n + k. Returns 0, or -1 if out of memory or if the
+// heap would exceed INT_MAX elements.
+int insertMany(Heap* heap, const int* keys, int k) {
+    if (k < 0 || k > INT_MAX - heap->count) return -1;
+    if (reserveHeap(heap, heap->count + k) != 0) return -1;
+    int total = heap->count + k;
+    int depth = 1;
+    while ((1LL << depth) <= total) depth++;
+
+    if ((long long)k * depth > total) {
+        memcpy(heap->arr + heap->count, keys, sizeof(int) * k);
+        heap->count = total;
+        for (int i = total / 2 - 1; i >= 0; i--)
+            heapify(heap, i);
+    } else {
+        for (int j = 0; j < k; j++)
+            insert(heap, keys[j]);
     }
+    return 0;
 }
 
 // Function to remove the root element (extract min/max)
@@ -98,6 +147,33 @@ int extract(Heap* heap) {
     return root;
 }
 
+// Function to remove up to `k` root elements into `out`, in heap order (smallest
+// first for a min-heap). Returns how many were removed.
+int extractK(Heap* heap, int k, int* out) {
+    int n = 0;
+    while (n < k && heap->count > 0)
+        out[n++] = extract(heap);
+    return n;
+}
+
+// Bounded top-k: a heap created with capacity k keeps the k largest keys
+// offered to it if it is a MIN_HEAP (the k smallest if it is a MAX_HEAP).
+// Once full, the root is the weakest key kept, so a candidate that does not
+// beat it is rejected with a single comparison; one that does replaces the
+// root and sifts down. Memory stays at k keys however many are offered.
+// Returns 1 if the key was kept.
+int offerTopK(Heap* heap, int key) {
+    if (heap->count < heap->capacity) {
+        insert(heap, key);
+        return 1;
+    }
+    if (heap->count == 0 || !higher(heap, heap->arr[0], key))
+        return 0;
+    heap->arr[0] = key;
+    heapify(heap, 0);
+    return 1;
+}
+
 // Function to display the heap
 void displayHeap(Heap* heap) {
     for (int i = 0; i < heap->count; i++)
@@ -105,6 +181,7 @@ void displayHeap(Heap* heap) {
     printf("\n");
 }
 
+#ifndef BINARY_HEAP_NO_MAIN
 int main() {
     // Create a min-heap with capacity 10
     Heap* minHeap = createHeap(10, MIN_HEAP);
@@ -127,9 +204,41 @@ int main() {
     printf("Min-Heap after extraction: ");
     displayHeap(minHeap);
 
-    // Free the heap
+    // Build a max-heap from an array in O(n), then add a batch
+    int keys[] = {4, 15, 8, 42, 16, 23};
+    int more[] = {1, 99, 50};
+    Heap* maxHeap = createHeap(2, MAX_HEAP);   // Grows as needed
+    buildHeap(maxHeap, keys, 6);
+    insertMany(maxHeap, more, 3);
+    printf("Max-Heap: ");
+    displayHeap(maxHeap);
+
+    int top[3];
+    int n = extractK(maxHeap, 3, top);
+    printf("Three largest:");
+    for (int i = 0; i < n; i++)
+        printf(" %d", top[i]);
+    printf("\n");
+
+    // Top 3 of a stream, keeping only 3 keys in memory
+    Heap* topK = createHeap(3, MIN_HEAP);
+    int stream[] = {5, 91, 12, 77, 3, 64, 88, 20};
+    for (int i = 0; i < 8; i++)
+        offerTopK(topK, stream[i]);
+    printf("Top 3 of the stream (weakest first):");
+    n = extractK(topK, 3, top);
+    for (int i = 0; i < n; i++)
+        printf(" %d", top[i]);
+    printf("\n");
+
+    // Free the heaps
     free(minHeap->arr);
     free(minHeap);
+    free(maxHeap->arr);
+    free(maxHeap);
+    free(topK->arr);
+    free(topK);
 
     return 0;
 }
+#endif
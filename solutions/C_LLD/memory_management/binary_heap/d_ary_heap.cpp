@@ -0,0 +1,202 @@
+/*
+ * Explanation:
+ *
+ * DaryHeap Class Template `DaryHeap<T, Arity, Compare>`:
+ * - A priority queue like the heap in binary_heap.c, but each node has `Arity` (2, 4 or 8)
+ *   children, and the ordering is a template parameter instead of a `heap_type` field.
+ *   `Compare` follows `std::priority_queue`: with `std::less<T>` the largest element is on
+ *   top (max-heap), with `std::greater<T>` the smallest (min-heap). `MinHeap` and `MaxHeap`
+ *   are shorthands. The comparison is inlined, so there is no branch on the heap type.
+ * - Sifting moves a hole instead of swapping: the element being placed is held aside,
+ *   parents (on `push`) or the best child (on `pop`) are moved into the hole, and the
+ *   element is written once where the hole stops. That is one move per level instead of
+ *   the three of a swap. Both sifts are loops; nothing recurses.
+ * - Storage grows by doubling, so `push` never fails for lack of capacity (`reserve` can
+ *   size it up front).
+ *
+ * Why more children:
+ * - A 4-ary heap is half as deep as a binary one, so `push` moves half as many elements.
+ *   `pop` compares more children per level, but they sit next to each other in memory, so
+ *   a level costs roughly one cache miss whatever the arity. Which arity is fastest
+ *   depends on the element size and the heap size; d_ary_heap_benchmark.cpp measures it.
+ *
+ * Layout:
+ * - The children of node `i` are at `Arity * i + 1 ... Arity * i + Arity`. The buffer is
+ *   64-byte aligned and the root is placed at offset `Arity - 1`, which makes every group
+ *   of siblings start at a multiple of `Arity * sizeof(T)`. When that is at most 64 bytes
+ *   (e.g. 4 or 8 ints, 4 pointers) a node's children always share one cache line.
+ *
+ * Implementation Details:
+ * - `T` must be nothrow move constructible; elements are moved, never copied, inside the
+ *   heap.
+ * - `top` and `pop` on an empty heap throw `std::out_of_range`, as `HashTable::get` does
+ *   for a missing key.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <stdexcept> // for std::out_of_range
+#include <type_traits>
+#include <utility>
+
+template <typename T, unsigned Arity = 4, typename Compare = std::less<T>>
+class DaryHeap {
+private:
+    static_assert(Arity >= 2, "a heap node needs at least two children");
+    static_assert(std::is_nothrow_move_constructible<T>::value,
+                  "elements are moved around the heap without a way to roll back");
+
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr size_t PAD = Arity - 1;   // Slots before the root
+
+    T* buffer = nullptr;      // Aligned allocation; `data` points into it
+    T* data = nullptr;        // data[0] is the root
+    size_t count = 0;
+    size_t capacity = 0;
+    Compare comp;             // comp(a, b): `a` has lower priority than `b`
+
+    static T* allocate(size_t slots) {
+        return static_cast<T*>(::operator new(slots * sizeof(T), std::align_val_t(ALIGNMENT)));
+    }
+
+    static void deallocate(T* p) {
+        ::operator delete(p, std::align_val_t(ALIGNMENT));
+    }
+
+    void grow(size_t min_capacity) {
+        size_t new_capacity = capacity ? capacity : 16;
+        while (new_capacity < min_capacity) new_capacity *= 2;
+
+        T* new_buffer = allocate(new_capacity + PAD);
+        T* new_data = new_buffer + PAD;
+        for (size_t i = 0; i < count; i++) {
+            ::new (static_cast<void*>(new_data + i)) T(std::move(data[i]));
+            data[i].~T();
+        }
+        if (buffer) deallocate(buffer);
+        buffer = new_buffer;
+        data = new_data;
+        capacity = new_capacity;
+    }
+
+    // Move the hole at `i` up until `value` fits, then fill it
+    void sift_up(size_t i, T value) {
+        while (i > 0) {
+            size_t parent = (i - 1) / Arity;
+            if (!comp(data[parent], value)) break;
+            data[i] = std::move(data[parent]);
+            i = parent;
+        }
+        data[i] = std::move(value);
+    }
+
+    // Index of the highest-priority child of `i`; `i` must have at least one child
+    size_t best_child(size_t i) const {
+        size_t first = Arity * i + 1;
+        size_t best = first;
+        if (first + Arity <= count) {
+            // All children present: fixed trip count, unrolled by the compiler
+            for (unsigned k = 1; k < Arity; k++) {
+                if (comp(data[best], data[first + k])) best = first + k;
+            }
+        } else {
+            for (size_t c = first + 1; c < count; c++) {
+                if (comp(data[best], data[c])) best = c;
+            }
+        }
+        return best;
+    }
+
+    // Move the hole at `i` down until `value` fits, then fill it
+    void sift_down(size_t i, T value) {
+        while (Arity * i + 1 < count) {
+            size_t best = best_child(i);
+            if (!comp(value, data[best])) break;
+            data[i] = std::move(data[best]);
+            i = best;
+        }
+        data[i] = std::move(value);
+    }
+
+public:
+    explicit DaryHeap(const Compare& comp = Compare()) : comp(comp) {}
+
+    ~DaryHeap() {
+        clear();
+        if (buffer) deallocate(buffer);
+    }
+
+    DaryHeap(const DaryHeap&) = delete;
+    DaryHeap& operator=(const DaryHeap&) = delete;
+
+    DaryHeap(DaryHeap&& other) noexcept
+        : buffer(other.buffer), data(other.data), count(other.count), capacity(other.capacity),
+          comp(std::move(other.comp)) {
+        other.buffer = other.data = nullptr;
+        other.count = other.capacity = 0;
+    }
+
+    // The old contents end up in `other` and are freed with it
+    DaryHeap& operator=(DaryHeap&& other) noexcept {
+        std::swap(buffer, other.buffer);
+        std::swap(data, other.data);
+        std::swap(count, other.count);
+        std::swap(capacity, other.capacity);
+        std::swap(comp, other.comp);
+        return *this;
+    }
+
+    void push(T value) {
+        if (count == capacity) grow(count + 1);
+        // The hole starts as a live element at the end, so sifts only ever move-assign
+        ::new (static_cast<void*>(data + count)) T(std::move(value));
+        count++;
+        sift_up(count - 1, std::move(data[count - 1]));
+    }
+
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        push(T(std::forward<Args>(args)...));
+    }
+
+    // Highest-priority element
+    const T& top() const {
+        if (count == 0) throw std::out_of_range("Heap is empty");
+        return data[0];
+    }
+
+    void pop() {
+        if (count == 0) throw std::out_of_range("Heap is empty");
+        T last = std::move(data[count - 1]);
+        data[count - 1].~T();
+        count--;
+        if (count > 0) sift_down(0, std::move(last));
+    }
+
+    // Remove and return the highest-priority element
+    T extract() {
+        if (count == 0) throw std::out_of_range("Heap is empty");
+        T root = std::move(data[0]);
+        pop();
+        return root;
+    }
+
+    void reserve(size_t n) {
+        if (n > capacity) grow(n);
+    }
+
+    void clear() {
+        for (size_t i = 0; i < count; i++) data[i].~T();
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+};
+
+template <typename T, unsigned Arity = 4>
+using MinHeap = DaryHeap<T, Arity, std::greater<T>>;
+
+template <typename T, unsigned Arity = 4>
+using MaxHeap = DaryHeap<T, Arity, std::less<T>>;
@@ -0,0 +1,150 @@
+/*
+ * Benchmark for DaryHeap against std::priority_queue.
+ *
+ * Explanation:
+ * - Heaps: `std::priority_queue` (a binary heap over `std::vector`) and `DaryHeap` with
+ *   arity 2, 4 and 8, all as min-heaps with the same comparator.
+ * - Element types: `uint32_t`, and a 16-byte `Event` (64-bit time + 64-bit id) ordered by
+ *   time, as in a timer queue or an event simulation.
+ * - Workloads:
+ *   - fill+drain: push N random keys, then pop all of them (heap sort).
+ *   - hold: the heap is filled to N, then each operation pops the minimum and pushes it
+ *     back with a random increment, so the size stays at N. This is the steady state of a
+ *     timer queue or a discrete-event simulator.
+ * - Sizes: 1K (fits L1), 64K (fits L2), 1M and 10M elements (larger than the last-level
+ *   cache for `Event`).
+ * - Reported: ns per push+pop pair. Every run folds the popped sequence into a checksum,
+ *   and all heaps must agree on it, which doubles as a correctness check.
+ *
+ * Build and run:
+ *   g++ -O2 -std=c++17 d_ary_heap_benchmark.cpp -o d_ary_heap_benchmark
+ *   ./d_ary_heap_benchmark [max elements]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "d_ary_heap.cpp"
+
+struct Event {
+    uint64_t time;
+    uint64_t id;
+    bool operator>(const Event& other) const { return time > other.time; }
+};
+
+// Small generator so the RNG does not dominate the measurement.
+struct XorShift {
+    uint64_t state;
+    explicit XorShift(uint64_t seed) : state(seed * 0x9e3779b97f4a7c15ULL + 1) {}
+    uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+template <typename T> T make(uint64_t key, uint64_t id);
+template <> uint32_t make<uint32_t>(uint64_t key, uint64_t) { return (uint32_t)key; }
+template <> Event make<Event>(uint64_t key, uint64_t id) { return Event{key, id}; }
+
+static uint64_t key_of(uint32_t v) { return v; }
+static uint64_t key_of(const Event& e) { return e.time; }
+
+// Common interface over the two kinds of heap
+template <typename T>
+struct StdHeap {
+    std::priority_queue<T, std::vector<T>, std::greater<T>> queue;
+    void reserve(size_t n) {
+        std::vector<T> storage;
+        storage.reserve(n);
+        queue = std::priority_queue<T, std::vector<T>, std::greater<T>>(std::greater<T>(), std::move(storage));
+    }
+    void push(const T& v) { queue.push(v); }
+    T extract() {
+        T v = queue.top();
+        queue.pop();
+        return v;
+    }
+};
+
+template <typename T, unsigned Arity>
+struct DHeap {
+    MinHeap<T, Arity> heap;
+    void reserve(size_t n) { heap.reserve(n); }
+    void push(const T& v) { heap.push(v); }
+    T extract() { return heap.extract(); }
+};
+
+struct Result {
+    double ns_per_pair;
+    uint64_t checksum;
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename T, typename Heap>
+Result fill_drain(size_t n) {
+    Heap heap;
+    heap.reserve(n);
+    XorShift rng(1);
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++) heap.push(make<T>(rng.next() >> 34, i));
+    for (size_t i = 0; i < n; i++) checksum = checksum * 31 + key_of(heap.extract());
+    return Result{seconds_since(start) * 1e9 / n, checksum};
+}
+
+template <typename T, typename Heap>
+Result hold(size_t n, size_t ops) {
+    Heap heap;
+    heap.reserve(n);
+    XorShift rng(2);
+    for (size_t i = 0; i < n; i++) heap.push(make<T>(rng.next() >> 40, i));
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ops; i++) {
+        uint64_t key = key_of(heap.extract());
+        checksum = checksum * 31 + key;
+        heap.push(make<T>(key + (rng.next() >> 44), i));
+    }
+    return Result{seconds_since(start) * 1e9 / ops, checksum};
+}
+
+template <typename T>
+void run(const char* type_name, size_t n) {
+    const char* names[] = {"std::priority_queue", "DaryHeap<2>", "DaryHeap<4>", "DaryHeap<8>"};
+    Result fill[4] = {
+        fill_drain<T, StdHeap<T>>(n), fill_drain<T, DHeap<T, 2>>(n),
+        fill_drain<T, DHeap<T, 4>>(n), fill_drain<T, DHeap<T, 8>>(n),
+    };
+    size_t ops = n < 1000000 ? 4000000 : 2 * n;
+    Result held[4] = {
+        hold<T, StdHeap<T>>(n, ops), hold<T, DHeap<T, 2>>(n, ops),
+        hold<T, DHeap<T, 4>>(n, ops), hold<T, DHeap<T, 8>>(n, ops),
+    };
+    for (int i = 0; i < 4; i++) {
+        bool ok = fill[i].checksum == fill[0].checksum && held[i].checksum == held[0].checksum;
+        printf("%-9s %10zu  %-20s %10.1f %10.1f %8.2fx %s\n", type_name, n, names[i], fill[i].ns_per_pair,
+               held[i].ns_per_pair, held[0].ns_per_pair / held[i].ns_per_pair, ok ? "" : "CHECKSUM MISMATCH");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t max_n = argc > 1 ? strtoull(argv[1], NULL, 10) : 10000000;
+    printf("ns per push+pop pair; speedup is for hold, against std::priority_queue\n");
+    printf("%-9s %10s  %-20s %10s %10s %9s\n", "element", "size", "heap", "fill+drain", "hold", "speedup");
+    for (size_t n : {size_t(1000), size_t(64000), size_t(1000000), size_t(10000000)}) {
+        if (n > max_n) break;
+        run<uint32_t>("uint32_t", n);
+        run<Event>("Event", n);
+    }
+    return 0;
+}
@@ -0,0 +1,291 @@
+/*
+ * Indexed (addressable) heap: the heap of binary_heap.c, plus a handle for every
+ * element so that an element can be found, re-prioritized or removed after it
+ * was inserted.
+ *
+ * - indexedInsert returns a HeapHandle. The handle stays valid until the
+ *   element leaves the heap (extracted or erased), however it moves inside.
+ * - A position map records where each handle's element currently sits in the
+ *   heap array. Every move during a sift updates it, so locating an element is
+ *   O(1) and updatePriority / eraseHandle cost one O(log n) sift, instead of a
+ *   linear search and a rebuild.
+ * - Handles carry a generation number. When an element leaves, its slot's
+ *   generation is bumped before the slot is reused, so an old handle is
+ *   recognized as stale (containsHandle returns 0, the others fail) instead of
+ *   silently naming a newer element. NO_HANDLE (0) is never issued.
+ * - Both arrays grow by doubling, so inserts do not fail when the initial
+ *   capacity is reached.
+ * - Sifts are loops that move a hole and write the sifted element once.
+ * - Priorities are int by default. Define INDEXED_HEAP_PRIORITY before
+ *   including this file to use another type, e.g. int64_t for deadlines in
+ *   microseconds.
+ *
+ * Example: a crawler frontier (see web_crawler_snippets.py), where
+ * extract_max_priority_page is indexedExtract on a max-heap,
+ * reduce_priority_link_to_crawl is updatePriority and remove_link_to_crawl is
+ * eraseHandle.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_HEAP 1
+#define MIN_HEAP 0
+
+// Low 32 bits: slot; high 32 bits: generation of the slot when it was issued.
+// Generations start at 1, so 0 is never a valid handle.
+typedef uint64_t HeapHandle;
+
+#define NO_HANDLE 0
+
+#ifndef INDEXED_HEAP_PRIORITY
+#define INDEXED_HEAP_PRIORITY int
+#endif
+
+typedef INDEXED_HEAP_PRIORITY HeapPriority;
+
+typedef struct {
+    HeapPriority priority;
+    uint32_t slot;      // Handle slot of the element
+} HeapEntry;
+
+typedef struct {
+    int position;       // Index in `entries`, or -1 if the slot is free
+    uint32_t generation;
+    int value;          // Caller's payload, e.g. a link id
+} HandleSlot;
+
+typedef struct {
+    HeapEntry *entries;
+    int count;
+    int capacity;
+    HandleSlot *slots;  // `capacity` slots
+    uint32_t *freeSlots;  // Stack of free slot numbers
+    int freeCount;
+    int heap_type;      // 0 for Min-Heap, 1 for Max-Heap
+} IndexedHeap;
+
+// Function to create an indexed heap. Returns NULL if out of memory.
+IndexedHeap* createIndexedHeap(int capacity, int heap_type) {
+    if (capacity < 1) capacity = 1;
+    IndexedHeap* heap = (IndexedHeap*)malloc(sizeof(IndexedHeap));
+    if (!heap) return NULL;
+    heap->entries = (HeapEntry*)malloc(sizeof(HeapEntry) * capacity);
+    heap->slots = (HandleSlot*)malloc(sizeof(HandleSlot) * capacity);
+    heap->freeSlots = (uint32_t*)malloc(sizeof(uint32_t) * capacity);
+    if (!heap->entries || !heap->slots || !heap->freeSlots) {
+        free(heap->entries);
+        free(heap->slots);
+        free(heap->freeSlots);
+        free(heap);
+        return NULL;
+    }
+    heap->count = 0;
+    heap->capacity = capacity;
+    heap->heap_type = heap_type;
+    // Push the slots so that slot 0 is handed out first
+    for (int i = 0; i < capacity; i++) {
+        heap->slots[i].position = -1;
+        heap->slots[i].generation = 1;
+        heap->freeSlots[i] = (uint32_t)(capacity - 1 - i);
+    }
+    heap->freeCount = capacity;
+    return heap;
+}
+
+// Nonzero if priority `a` belongs above priority `b`
+static int higher(const IndexedHeap* heap, HeapPriority a, HeapPriority b) {
+    return heap->heap_type == MAX_HEAP ? a > b : a < b;
+}
+
+// Write an entry at `i` and record its new position
+static void place(IndexedHeap* heap, int i, HeapEntry entry) {
+    heap->entries[i] = entry;
+    heap->slots[entry.slot].position = i;
+}
+
+// Sift `entry` up from the hole at `i`
+static void siftUp(IndexedHeap* heap, int i, HeapEntry entry) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!higher(heap, entry.priority, heap->entries[parent].priority)) break;
+        place(heap, i, heap->entries[parent]);
+        i = parent;
+    }
+    place(heap, i, entry);
+}
+
+// Sift `entry` down from the hole at `i`
+static void siftDown(IndexedHeap* heap, int i, HeapEntry entry) {
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count &&
+            higher(heap, heap->entries[child + 1].priority, heap->entries[child].priority)) {
+            child++;
+        }
+        if (!higher(heap, heap->entries[child].priority, entry.priority)) break;
+        place(heap, i, heap->entries[child]);
+        i = child;
+    }
+    place(heap, i, entry);
+}
+
+// Put `entry` into the hole at `i`, moving it up or down as needed
+static void fillHole(IndexedHeap* heap, int i, HeapEntry entry) {
+    if (i > 0 && higher(heap, entry.priority, heap->entries[(i - 1) / 2].priority)) {
+        siftUp(heap, i, entry);
+    } else {
+        siftDown(heap, i, entry);
+    }
+}
+
+// Position of a live handle's element, or -1 if the handle is stale or invalid
+static int positionOf(const IndexedHeap* heap, HeapHandle handle) {
+    uint32_t slot = (uint32_t)handle;
+    if (slot >= (uint32_t)heap->capacity) return -1;
+    if (heap->slots[slot].generation != (uint32_t)(handle >> 32)) return -1;
+    return heap->slots[slot].position;
+}
+
+// Take the element at `i` out of the heap and retire its handle
+static void removeAt(IndexedHeap* heap, int i) {
+    uint32_t slot = heap->entries[i].slot;
+    heap->slots[slot].position = -1;
+    // Old handles to this slot become stale
+    if (++heap->slots[slot].generation == 0) heap->slots[slot].generation = 1;
+    heap->freeSlots[heap->freeCount++] = slot;
+
+    heap->count--;
+    if (i < heap->count) fillHole(heap, i, heap->entries[heap->count]);
+}
+
+static int grow(IndexedHeap* heap) {
+    int capacity = heap->capacity * 2;
+    HeapEntry* entries = (HeapEntry*)realloc(heap->entries, sizeof(HeapEntry) * capacity);
+    if (!entries) return -1;
+    heap->entries = entries;
+    HandleSlot* slots = (HandleSlot*)realloc(heap->slots, sizeof(HandleSlot) * capacity);
+    if (!slots) return -1;
+    heap->slots = slots;
+    uint32_t* freeSlots = (uint32_t*)realloc(heap->freeSlots, sizeof(uint32_t) * capacity);
+    if (!freeSlots) return -1;
+    heap->freeSlots = freeSlots;
+
+    for (int i = capacity - 1; i >= heap->capacity; i--) {
+        heap->slots[i].position = -1;
+        heap->slots[i].generation = 1;
+        heap->freeSlots[heap->freeCount++] = (uint32_t)i;
+    }
+    heap->capacity = capacity;
+    return 0;
+}
+
+// Function to insert an element. Returns its handle, or NO_HANDLE if out of memory.
+HeapHandle indexedInsert(IndexedHeap* heap, HeapPriority priority, int value) {
+    if (heap->freeCount == 0 && grow(heap) != 0) return NO_HANDLE;
+    uint32_t slot = heap->freeSlots[--heap->freeCount];
+    heap->slots[slot].value = value;
+
+    HeapEntry entry = {priority, slot};
+    heap->count++;
+    siftUp(heap, heap->count - 1, entry);
+    return (HeapHandle)heap->slots[slot].generation << 32 | slot;
+}
+
+// Function to remove the root element. Returns -1 if the heap is empty; otherwise
+// stores its priority and value (either pointer may be NULL) and returns 0.
+int indexedExtract(IndexedHeap* heap, HeapPriority* priority, int* value) {
+    if (heap->count == 0) return -1;
+    HeapEntry root = heap->entries[0];
+    if (priority) *priority = root.priority;
+    if (value) *value = heap->slots[root.slot].value;
+    removeAt(heap, 0);
+    return 0;
+}
+
+// Nonzero if the handle's element is still in the heap
+int containsHandle(const IndexedHeap* heap, HeapHandle handle) {
+    return positionOf(heap, handle) >= 0;
+}
+
+// Change an element's priority, in either direction. Returns -1 for a stale handle.
+int updatePriority(IndexedHeap* heap, HeapHandle handle, HeapPriority priority) {
+    int i = positionOf(heap, handle);
+    if (i < 0) return -1;
+    HeapEntry entry = heap->entries[i];
+    entry.priority = priority;
+    fillHole(heap, i, entry);
+    return 0;
+}
+
+// Remove an element. Returns -1 for a stale handle.
+int eraseHandle(IndexedHeap* heap, HeapHandle handle) {
+    int i = positionOf(heap, handle);
+    if (i < 0) return -1;
+    removeAt(heap, i);
+    return 0;
+}
+
+// Current priority of an element, stored in *priority. Returns -1 for a stale handle.
+int getPriority(const IndexedHeap* heap, HeapHandle handle, HeapPriority* priority) {
+    int i = positionOf(heap, handle);
+    if (i < 0) return -1;
+    *priority = heap->entries[i].priority;
+    return 0;
+}
+
+// Function to display the heap as (priority, value) pairs
+void displayIndexedHeap(const IndexedHeap* heap) {
+    for (int i = 0; i < heap->count; i++)
+        printf("(%lld, %d) ", (long long)heap->entries[i].priority, heap->slots[heap->entries[i].slot].value);
+    printf("\n");
+}
+
+void freeIndexedHeap(IndexedHeap* heap) {
+    free(heap->entries);
+    free(heap->slots);
+    free(heap->freeSlots);
+    free(heap);
+}
+
+#ifndef INDEXED_HEAP_NO_MAIN
+int main() {
+    // Crawler frontier: value = link id, priority = page rank
+    const char* links[] = {"a.com", "b.com", "c.com", "d.com", "e.com"};
+    int ranks[] = {50, 80, 30, 70, 60};
+    IndexedHeap* frontier = createIndexedHeap(2, MAX_HEAP);   // Grows as needed
+    if (!frontier) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    HeapHandle handles[5];
+    for (int i = 0; i < 5; i++) handles[i] = indexedInsert(frontier, ranks[i], i);
+    printf("Frontier: ");
+    displayIndexedHeap(frontier);
+
+    // b.com turned out similar to a crawled page: reduce_priority_link_to_crawl
+    updatePriority(frontier, handles[1], 10);
+    // d.com was removed from the crawl list: remove_link_to_crawl
+    eraseHandle(frontier, handles[3]);
+    printf("After reducing b.com and removing d.com: ");
+    displayIndexedHeap(frontier);
+
+    HeapPriority priority;
+    int link;
+    while (indexedExtract(frontier, &priority, &link) == 0) {
+        printf("Crawl %s (priority %lld)\n", links[link], (long long)priority);
+    }
+
+    // Handles of elements that left the heap are stale, even after slot reuse
+    HeapHandle reused = indexedInsert(frontier, 1, 0);
+    printf("contains(old a.com handle) = %d, contains(new handle) = %d\n",
+           containsHandle(frontier, handles[0]), containsHandle(frontier, reused));
+    printf("update(old handle) = %d\n", updatePriority(frontier, handles[0], 99));
+
+    freeIndexedHeap(frontier);
+    return 0;
+}
+#endif
@@ -0,0 +1,346 @@
+/*
+ * Concurrent priority queue for many threads: a relaxed MultiQueue built from
+ * the Heap of binary_heap.c.
+ *
+ * - One Heap behind one mutex makes every thread queue up on the root, so
+ *   throughput stops growing at one thread. A MultiQueue instead keeps
+ *   c * T heaps for T threads, each with its own lock.
+ * - mqInsert puts the key into a random heap. If that heap's lock is taken it
+ *   simply tries another one, so an insert never waits.
+ * - mqDeleteMin looks at the roots of `samples` random heaps (2 by default)
+ *   and pops from the one with the smallest root. It trylocks that heap and
+ *   resamples on failure.
+ * - Each heap publishes its root in an atomic `top`, so sampling reads no lock
+ *   and touches one cache line per heap. Heaps are aligned to cache lines so
+ *   that two heaps never share one.
+ * - The result is relaxed: mqDeleteMin returns a key near the minimum, not
+ *   necessarily the minimum. How near is the *rank error* (how many smaller
+ *   keys were in the queue at that moment). It grows with the number of heaps
+ *   (c) and shrinks with more samples; both are parameters of
+ *   createMultiQueue. With 2 samples the expected rank error is O(c * T),
+ *   independent of the queue size. This suits job queues and parallel
+ *   best-first search, where "one of the most urgent" is good enough.
+ * - mqDeleteMin reports empty only after a full scan finds every heap empty.
+ *
+ * The example below measures throughput against a Heap behind a mutex, and
+ * the distribution of rank errors, from 1 to 64 threads.
+ *
+ * Build and run:
+ *   gcc -O2 -pthread multi_queue.c -o multi_queue
+ *   ./multi_queue [seconds per throughput run]
+ */
+
+#define BINARY_HEAP_NO_MAIN
+#include "binary_heap.c"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+#define CACHE_LINE 64
+#define MQ_EMPTY INT_MAX        // `top` of an empty heap
+
+typedef struct SubQueue {
+    _Alignas(CACHE_LINE) pthread_mutex_t lock;
+    _Atomic int top;            // Root key, or MQ_EMPTY; read without the lock
+    Heap *heap;
+} SubQueue;
+
+typedef struct MultiQueue {
+    SubQueue *queues;
+    int count;                  // c * threads
+    int samples;                // Heaps compared by mqDeleteMin
+    // Optional: called with the heap still locked after each insert (1) or
+    // delete (0), so a test can record a valid linearization order
+    void (*trace)(int inserted, int key);
+} MultiQueue;
+
+void freeMultiQueue(MultiQueue *mq);
+
+// Per-thread random number generator, seeded on first use
+static _Thread_local uint64_t mqRandomState;
+
+static uint32_t mqRandom(void) {
+    if (mqRandomState == 0) mqRandomState = (uint64_t)(uintptr_t)&mqRandomState * 0x9e3779b97f4a7c15ULL | 1;
+    mqRandomState ^= mqRandomState << 13;
+    mqRandomState ^= mqRandomState >> 7;
+    mqRandomState ^= mqRandomState << 17;
+    return (uint32_t)(mqRandomState >> 32);
+}
+
+// Create a queue for `threads` threads with `c` heaps per thread. `samples` is
+// how many heaps mqDeleteMin compares (at least 1; 2 is the usual choice).
+// Returns NULL if out of memory.
+MultiQueue *createMultiQueue(int threads, int c, int samples) {
+    MultiQueue *mq = (MultiQueue *)malloc(sizeof(MultiQueue));
+    if (!mq) return NULL;
+    mq->count = (threads > 0 ? threads : 1) * (c > 0 ? c : 1);
+    mq->samples = samples > 0 ? samples : 1;
+    mq->trace = NULL;
+    mq->queues = (SubQueue *)aligned_alloc(CACHE_LINE, mq->count * sizeof(SubQueue));
+    if (!mq->queues) {
+        free(mq);
+        return NULL;
+    }
+    for (int i = 0; i < mq->count; i++) {
+        SubQueue *q = &mq->queues[i];
+        pthread_mutex_init(&q->lock, NULL);
+        atomic_init(&q->top, MQ_EMPTY);
+        q->heap = createHeap(64, MIN_HEAP);
+        if (!q->heap) {
+            mq->count = i;
+            freeMultiQueue(mq);
+            return NULL;
+        }
+    }
+    return mq;
+}
+
+static void publishTop(SubQueue *q) {
+    atomic_store_explicit(&q->top, q->heap->count > 0 ? q->heap->arr[0] : MQ_EMPTY, memory_order_release);
+}
+
+// Add a key (MQ_EMPTY itself cannot be stored)
+void mqInsert(MultiQueue *mq, int key) {
+    for (;;) {
+        SubQueue *q = &mq->queues[mqRandom() % mq->count];
+        if (pthread_mutex_trylock(&q->lock) != 0) continue;
+        insert(q->heap, key);
+        publishTop(q);
+        if (mq->trace) mq->trace(1, key);
+        pthread_mutex_unlock(&q->lock);
+        return;
+    }
+}
+
+// Remove a key close to the minimum into *key. Returns 1, or 0 if the queue is empty.
+int mqDeleteMin(MultiQueue *mq, int *key) {
+    for (;;) {
+        SubQueue *best = NULL;
+        int bestTop = MQ_EMPTY;
+        for (int s = 0; s < mq->samples; s++) {
+            SubQueue *q = &mq->queues[mqRandom() % mq->count];
+            int top = atomic_load_explicit(&q->top, memory_order_acquire);
+            if (top < bestTop) {
+                bestTop = top;
+                best = q;
+            }
+        }
+        if (!best) {
+            // Every sampled heap was empty: look for any non-empty one
+            for (int i = 0; i < mq->count && !best; i++) {
+                if (atomic_load_explicit(&mq->queues[i].top, memory_order_acquire) != MQ_EMPTY) {
+                    best = &mq->queues[i];
+                }
+            }
+            if (!best) return 0;
+        }
+
+        if (pthread_mutex_trylock(&best->lock) != 0) continue;
+        if (best->heap->count == 0) {   // Emptied since it was sampled
+            pthread_mutex_unlock(&best->lock);
+            continue;
+        }
+        *key = extract(best->heap);
+        publishTop(best);
+        if (mq->trace) mq->trace(0, *key);
+        pthread_mutex_unlock(&best->lock);
+        return 1;
+    }
+}
+
+void freeMultiQueue(MultiQueue *mq) {
+    for (int i = 0; i < mq->count; i++) {
+        pthread_mutex_destroy(&mq->queues[i].lock);
+        free(mq->queues[i].heap->arr);
+        free(mq->queues[i].heap);
+    }
+    free(mq->queues);
+    free(mq);
+}
+
+// Example usage: throughput and rank error
+
+#define KEY_BITS 20                 // Keys are random in [0, 2^20)
+#define PREFILL (1 << 20)
+#define TRACE_OPS 400000            // Operations per rank-error run (all threads)
+#define MAX_THREADS 64
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Baseline: the single Heap behind one mutex
+typedef struct LockedHeap {
+    pthread_mutex_t lock;
+    Heap *heap;
+} LockedHeap;
+
+typedef struct WorkerArgs {
+    MultiQueue *mq;                 // Either this...
+    LockedHeap *locked;             // ...or this
+    _Atomic int *stop;
+    long ops;                       // Run until *stop, or for this many ops if nonzero
+    long done;
+} WorkerArgs;
+
+// Each thread alternates insert and delete-min, so the queue size stays constant
+static void *worker(void *arg) {
+    WorkerArgs *args = (WorkerArgs *)arg;
+    long done = 0;
+    int key;
+    while (args->ops ? done < args->ops : !atomic_load_explicit(args->stop, memory_order_relaxed)) {
+        int newKey = (int)(mqRandom() >> (32 - KEY_BITS));
+        if (args->mq) {
+            mqInsert(args->mq, newKey);
+            mqDeleteMin(args->mq, &key);
+        } else {
+            pthread_mutex_lock(&args->locked->lock);
+            insert(args->locked->heap, newKey);
+            extract(args->locked->heap);
+            pthread_mutex_unlock(&args->locked->lock);
+        }
+        done += 2;
+    }
+    args->done = done;
+    return NULL;
+}
+
+// Run `threads` workers for `seconds` (or `ops` operations in total); returns ops/s
+static double runWorkers(MultiQueue *mq, LockedHeap *locked, int threads, double seconds, long ops) {
+    pthread_t ids[MAX_THREADS];
+    WorkerArgs args[MAX_THREADS];
+    _Atomic int stop = 0;
+    double start = nowSeconds();
+    for (int i = 0; i < threads; i++) {
+        args[i] = (WorkerArgs){mq, locked, &stop, ops / threads, 0};
+        pthread_create(&ids[i], NULL, worker, &args[i]);
+    }
+    if (!ops) {
+        struct timespec pause = {(time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9)};
+        nanosleep(&pause, NULL);
+        atomic_store(&stop, 1);
+    }
+    long total = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(ids[i], NULL);
+        total += args[i].done;
+    }
+    return total / (nowSeconds() - start);
+}
+
+// Rank error: every operation takes a ticket while its heap is locked, which
+// orders the operations consistently with what each heap saw. Replaying them
+// in ticket order against a Fenwick tree over the key space gives, for each
+// delete, how many smaller keys were in the queue at that point.
+typedef struct TraceEvent {
+    int key;
+    int inserted;
+} TraceEvent;
+
+static TraceEvent *traceEvents;
+static _Atomic long traceTicket;
+
+static void recordEvent(int inserted, int key) {
+    long ticket = atomic_fetch_add_explicit(&traceTicket, 1, memory_order_relaxed);
+    traceEvents[ticket] = (TraceEvent){key, inserted};
+}
+
+static void fenwickAdd(int *tree, int size, int i, int delta) {
+    for (i++; i <= size; i += i & -i) tree[i] += delta;
+}
+
+static int fenwickPrefix(const int *tree, int i) {   // Sum of [0, i)
+    int sum = 0;
+    for (; i > 0; i -= i & -i) sum += tree[i];
+    return sum;
+}
+
+static int compareLong(const void *a, const void *b) {
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+// Prefill, trace TRACE_OPS operations, and print the rank error distribution
+static void measureRankError(int threads, int c, int samples) {
+    MultiQueue *mq = createMultiQueue(threads, c, samples);
+    int size = 1 << KEY_BITS;
+    int *tree = (int *)calloc(size + 1, sizeof(int));
+    // Prefill keys are inserted before tracing; add them to the tree directly
+    for (int i = 0; i < PREFILL; i++) {
+        int key = (int)(mqRandom() >> (32 - KEY_BITS));
+        mqInsert(mq, key);
+        fenwickAdd(tree, size, key, 1);
+    }
+
+    long events = TRACE_OPS + 2L * threads;   // Each thread may overshoot by one pair
+    traceEvents = (TraceEvent *)malloc(events * sizeof(TraceEvent));
+    atomic_store(&traceTicket, 0);
+    mq->trace = recordEvent;
+    runWorkers(mq, NULL, threads, 0, TRACE_OPS);
+    mq->trace = NULL;
+    long recorded = atomic_load(&traceTicket);
+
+    long *errors = (long *)malloc(recorded * sizeof(long));
+    long deletes = 0;
+    double sum = 0;
+    for (long i = 0; i < recorded; i++) {
+        TraceEvent *e = &traceEvents[i];
+        if (e->inserted) {
+            fenwickAdd(tree, size, e->key, 1);
+        } else {
+            errors[deletes] = fenwickPrefix(tree, e->key);   // Smaller keys present
+            sum += errors[deletes++];
+            fenwickAdd(tree, size, e->key, -1);
+        }
+    }
+    qsort(errors, deletes, sizeof(long), compareLong);
+    printf("%2d threads, c=%d, %d samples: rank error mean %7.1f  p50 %5ld  p99 %6ld  max %6ld\n", threads, c,
+           samples, sum / deletes, errors[deletes / 2], errors[deletes * 99 / 100], errors[deletes - 1]);
+
+    free(errors);
+    free(traceEvents);
+    free(tree);
+    freeMultiQueue(mq);
+}
+
+int main(int argc, char *argv[]) {
+    double seconds = argc > 1 ? atof(argv[1]) : 0.3;
+
+    printf("Throughput (M ops/s, insert + delete-min pairs on %d keys)\n", PREFILL);
+    printf("%8s %14s %18s\n", "threads", "Heap + mutex", "MultiQueue c=2");
+    for (int threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        LockedHeap locked = {PTHREAD_MUTEX_INITIALIZER, createHeap(PREFILL, MIN_HEAP)};
+        MultiQueue *mq = createMultiQueue(threads, 2, 2);
+        if (!locked.heap || !mq) {
+            fprintf(stderr, "Out of memory\n");
+            return EXIT_FAILURE;
+        }
+        for (int i = 0; i < PREFILL; i++) {
+            int key = (int)(mqRandom() >> (32 - KEY_BITS));
+            insert(locked.heap, key);
+            mqInsert(mq, key);
+        }
+        double lockedRate = runWorkers(NULL, &locked, threads, seconds, 0);
+        double mqRate = runWorkers(mq, NULL, threads, seconds, 0);
+        printf("%8d %14.2f %18.2f\n", threads, lockedRate / 1e6, mqRate / 1e6);
+        free(locked.heap->arr);
+        free(locked.heap);
+        freeMultiQueue(mq);
+    }
+
+    printf("\nRank error of delete-min (0 = exact minimum)\n");
+    for (int threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        measureRankError(threads, 2, 2);
+    }
+    printf("\nRelaxation settings at 8 threads\n");
+    measureRankError(8, 1, 2);
+    measureRankError(8, 4, 2);
+    measureRankError(8, 2, 4);
+    measureRankError(8, 2, 1);
+    return 0;
+}
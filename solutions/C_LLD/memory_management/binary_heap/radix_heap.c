@@ -0,0 +1,167 @@
+/*
+ * Radix heap: a min-priority queue for monotone keys, i.e. keys that are never
+ * smaller than the last key extracted. Timer queues (a timer is never set in
+ * the past) and Dijkstra's algorithm (a new tentative distance is never below
+ * the distance just settled) produce exactly this pattern.
+ *
+ * - Same interface as the Heap in binary_heap.c: radixInsert / radixExtract.
+ * - Keys are RadixKey, 64-bit unsigned by default; compile with
+ *   -DRADIX_KEY_BITS=32 for 32-bit keys (half the memory per element).
+ * - Elements live in RADIX_KEY_BITS + 1 buckets. A key goes into the bucket
+ *   numbered by the highest bit in which it differs from `last`, the last key
+ *   extracted (bucket 0 holds keys equal to `last`). Every key in bucket i is
+ *   smaller than every key in bucket i + 1, and no comparisons are needed to
+ *   insert: one XOR and one count-leading-zeros.
+ * - radixExtract pops from bucket 0. When that is empty, it takes the first
+ *   non-empty bucket, makes its minimum the new `last` and redistributes the
+ *   bucket. Each of its keys now shares more leading bits with `last`, so it
+ *   lands in a strictly lower bucket. A key can only move down RADIX_KEY_BITS
+ *   times, so insert plus extract costs O(1) amortized per key (O(key bits) in
+ *   the worst case), independent of the number of elements.
+ * - Inserting a key below `last` breaks the monotone contract and is rejected.
+ * - Buckets are arrays that grow by doubling and keep their memory, so a heap
+ *   in steady state does not allocate.
+ * - Only the minimum is ordered: keys inside a bucket are unsorted, and an
+ *   extract that empties bucket 0 pays for scanning and moving one bucket.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef RADIX_KEY_BITS
+#define RADIX_KEY_BITS 64
+#endif
+
+#if RADIX_KEY_BITS == 64
+typedef uint64_t RadixKey;
+#define RADIX_CLZ(x) __builtin_clzll(x)
+#elif RADIX_KEY_BITS == 32
+typedef uint32_t RadixKey;
+#define RADIX_CLZ(x) __builtin_clz(x)
+#else
+#error "RADIX_KEY_BITS must be 32 or 64"
+#endif
+
+#define RADIX_BUCKETS (RADIX_KEY_BITS + 1)
+#define RADIX_EMPTY ((RadixKey)-1)   // Returned by radixExtract on an empty heap
+
+typedef struct {
+    RadixKey *keys;
+    uint32_t count;
+    uint32_t capacity;
+} RadixBucket;
+
+typedef struct {
+    RadixBucket buckets[RADIX_BUCKETS];
+    RadixKey last;       // Last key extracted; no key in the heap is smaller
+    size_t count;
+} RadixHeap;
+
+// Function to create a radix heap. Returns NULL if out of memory.
+RadixHeap* createRadixHeap(void) {
+    return (RadixHeap*)calloc(1, sizeof(RadixHeap));
+}
+
+// Bucket of `key` relative to the last extracted key
+static int bucketOf(RadixKey key, RadixKey last) {
+    return key == last ? 0 : RADIX_KEY_BITS - RADIX_CLZ(key ^ last);
+}
+
+// Make room for `extra` more keys. Returns 0, or -1 if out of memory.
+static int bucketReserve(RadixBucket *bucket, uint32_t extra) {
+    if (bucket->count + extra <= bucket->capacity) return 0;
+    uint32_t capacity = bucket->capacity ? bucket->capacity : 16;
+    while (capacity < bucket->count + extra) capacity *= 2;
+    RadixKey *keys = (RadixKey*)realloc(bucket->keys, sizeof(RadixKey) * capacity);
+    if (!keys) return -1;
+    bucket->keys = keys;
+    bucket->capacity = capacity;
+    return 0;
+}
+
+// Function to insert a key. Returns 0, or -1 if the key is below the last key
+// extracted or if out of memory.
+int radixInsert(RadixHeap* heap, RadixKey key) {
+    if (key < heap->last) return -1;
+    RadixBucket *bucket = &heap->buckets[bucketOf(key, heap->last)];
+    if (bucketReserve(bucket, 1) != 0) return -1;
+    bucket->keys[bucket->count++] = key;
+    heap->count++;
+    return 0;
+}
+
+// Function to remove the minimum key. Returns RADIX_EMPTY if the heap is empty
+// (or if out of memory, in which case the heap is unchanged).
+RadixKey radixExtract(RadixHeap* heap) {
+    if (heap->count == 0) return RADIX_EMPTY;
+
+    if (heap->buckets[0].count == 0) {
+        int i = 1;
+        while (heap->buckets[i].count == 0) i++;
+
+        // The bucket's minimum becomes `last`; everything in it moves lower.
+        // Lower buckets are sized first so that the move cannot fail halfway.
+        RadixBucket *bucket = &heap->buckets[i];
+        RadixKey min = bucket->keys[0];
+        for (uint32_t j = 1; j < bucket->count; j++) {
+            if (bucket->keys[j] < min) min = bucket->keys[j];
+        }
+        uint32_t moving[RADIX_BUCKETS] = {0};
+        for (uint32_t j = 0; j < bucket->count; j++)
+            moving[bucketOf(bucket->keys[j], min)]++;
+        for (int b = 0; b < i; b++) {
+            if (moving[b] && bucketReserve(&heap->buckets[b], moving[b]) != 0) return RADIX_EMPTY;
+        }
+
+        heap->last = min;
+        for (uint32_t j = 0; j < bucket->count; j++) {
+            RadixKey key = bucket->keys[j];
+            RadixBucket *target = &heap->buckets[bucketOf(key, min)];
+            target->keys[target->count++] = key;
+        }
+        bucket->count = 0;
+    }
+
+    heap->count--;
+    return heap->buckets[0].keys[--heap->buckets[0].count];
+}
+
+// Number of keys in the heap
+size_t radixSize(const RadixHeap* heap) {
+    return heap->count;
+}
+
+void freeRadixHeap(RadixHeap* heap) {
+    for (int i = 0; i < RADIX_BUCKETS; i++)
+        free(heap->buckets[i].keys);
+    free(heap);
+}
+
+#ifndef RADIX_HEAP_NO_MAIN
+int main() {
+    RadixHeap* heap = createRadixHeap();
+    if (!heap) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    // Timer expirations: keys only grow past what has been extracted
+    RadixKey timers[] = {30, 10, 50, 20, 40};
+    for (int i = 0; i < 5; i++)
+        radixInsert(heap, timers[i]);
+
+    printf("Extracted: %llu\n", (unsigned long long)radixExtract(heap));   // 10
+    printf("Extracted: %llu\n", (unsigned long long)radixExtract(heap));   // 20
+    radixInsert(heap, 25);     // Allowed: not below 20
+    printf("insert(5) after extracting 20: %d (rejected)\n", radixInsert(heap, 5));
+
+    printf("Remaining in order:");
+    while (radixSize(heap) > 0)
+        printf(" %llu", (unsigned long long)radixExtract(heap));
+    printf("\n");
+
+    freeRadixHeap(heap);
+    return 0;
+}
+#endif
@@ -0,0 +1,180 @@
+/*
+ * Benchmark for the radix heap against the binary heap of binary_heap.c.
+ *
+ * Explanation:
+ * - Dijkstra: shortest paths from vertex 0 in a random graph with 2^16 vertices and
+ *   DEGREE out-edges per vertex (weights 1..255), using lazy deletion: a vertex is pushed
+ *   again whenever its distance improves and stale entries are skipped when popped.
+ *   Heap keys pack (distance << 16 | vertex), which keeps them monotone and lets both
+ *   heaps carry the vertex without a payload field.
+ * - Timers: N pending timers; each operation expires the earliest one and re-arms it
+ *   1..65536 ticks after the current time (the "hold" model of a timer queue), for 1K,
+ *   100K and 1M timers.
+ * - Both heaps see the same keys and must extract the same sequence; a checksum of it is
+ *   compared, and the Dijkstra distances must match.
+ * - Reported: total time and ns per insert+extract pair.
+ *
+ * Build and run (the radix heap key width is chosen at compile time):
+ *   gcc -O2 radix_heap_benchmark.c -o radix_heap_benchmark
+ *   gcc -O2 -DRADIX_KEY_BITS=32 radix_heap_benchmark.c -o radix_heap_benchmark32
+ *   ./radix_heap_benchmark [timer operations]
+ */
+
+#define BINARY_HEAP_NO_MAIN
+#define RADIX_HEAP_NO_MAIN
+#include "binary_heap.c"
+#include "radix_heap.c"
+
+#include <time.h>
+
+#define VERTEX_BITS 16
+#define VERTICES (1 << VERTEX_BITS)
+#define DEGREE 8
+
+static double secondsSince(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static uint64_t rngState = 88172645463325252ULL;
+
+static uint64_t nextRandom(void) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+typedef struct {
+    uint32_t to;
+    uint32_t weight;
+} Edge;
+
+// One heap interface over both implementations, so each workload is written once
+typedef struct {
+    const char *name;
+    void *(*create)(void);
+    void (*push)(void *heap, uint64_t key);
+    uint64_t (*pop)(void *heap);
+    int (*empty)(void *heap);
+    void (*destroy)(void *heap);
+} HeapOps;
+
+static void *binaryCreate(void) { return createHeap(1024, MIN_HEAP); }
+static void binaryPush(void *heap, uint64_t key) { insert((Heap *)heap, (int)key); }
+static uint64_t binaryPop(void *heap) { return (uint64_t)extract((Heap *)heap); }
+static int binaryEmpty(void *heap) { return ((Heap *)heap)->count == 0; }
+static void binaryDestroy(void *heap) {
+    free(((Heap *)heap)->arr);
+    free(heap);
+}
+
+static void *radixCreate(void) { return createRadixHeap(); }
+static void radixPush(void *heap, uint64_t key) { radixInsert((RadixHeap *)heap, (RadixKey)key); }
+static uint64_t radixPop(void *heap) { return radixExtract((RadixHeap *)heap); }
+static int radixEmpty(void *heap) { return radixSize((RadixHeap *)heap) == 0; }
+static void radixDestroy(void *heap) { freeRadixHeap((RadixHeap *)heap); }
+
+static const HeapOps heaps[] = {
+    {"binary heap", binaryCreate, binaryPush, binaryPop, binaryEmpty, binaryDestroy},
+    {"radix heap", radixCreate, radixPush, radixPop, radixEmpty, radixDestroy},
+};
+
+// Dijkstra from vertex 0; returns the number of heap pushes and fills `dist`
+static uint64_t dijkstra(const HeapOps *ops, const Edge *edges, uint32_t *dist) {
+    for (int v = 0; v < VERTICES; v++) dist[v] = UINT32_MAX;
+    void *heap = ops->create();
+    dist[0] = 0;
+    ops->push(heap, 0);
+    uint64_t pushes = 1;
+    while (!ops->empty(heap)) {
+        uint64_t key = ops->pop(heap);
+        uint32_t d = (uint32_t)(key >> VERTEX_BITS);
+        uint32_t v = (uint32_t)(key & (VERTICES - 1));
+        if (d != dist[v]) continue;   // Stale entry
+        for (int e = 0; e < DEGREE; e++) {
+            const Edge *edge = &edges[v * DEGREE + e];
+            uint32_t nd = d + edge->weight;
+            if (nd < dist[edge->to]) {
+                dist[edge->to] = nd;
+                ops->push(heap, (uint64_t)nd << VERTEX_BITS | edge->to);
+                pushes++;
+            }
+        }
+    }
+    ops->destroy(heap);
+    return pushes;
+}
+
+// Hold model: returns a checksum of the expired sequence
+static uint64_t timers(const HeapOps *ops, int pending, long operations) {
+    void *heap = ops->create();
+    rngState = 12345;
+    for (int i = 0; i < pending; i++) ops->push(heap, 1 + nextRandom() % 65536);
+    uint64_t checksum = 0;
+    for (long i = 0; i < operations; i++) {
+        uint64_t now = ops->pop(heap);
+        checksum = checksum * 31 + now;
+        ops->push(heap, now + 1 + nextRandom() % 65536);
+    }
+    ops->destroy(heap);
+    return checksum;
+}
+
+int main(int argc, char *argv[]) {
+    long operations = argc > 1 ? atol(argv[1]) : 10000000;
+    printf("radix heap keys: %d bits\n", RADIX_KEY_BITS);
+
+    // Dijkstra
+    Edge *edges = (Edge *)malloc(sizeof(Edge) * VERTICES * DEGREE);
+    uint32_t *dist[2] = {(uint32_t *)malloc(sizeof(uint32_t) * VERTICES),
+                         (uint32_t *)malloc(sizeof(uint32_t) * VERTICES)};
+    if (!edges || !dist[0] || !dist[1]) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < VERTICES * DEGREE; i++) {
+        edges[i].to = (uint32_t)(nextRandom() % VERTICES);
+        edges[i].weight = 1 + (uint32_t)(nextRandom() % 255);
+    }
+    for (int h = 0; h < 2; h++) {
+        const int runs = 20;
+        uint64_t pushes = 0;
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int r = 0; r < runs; r++) pushes += dijkstra(&heaps[h], edges, dist[h]);
+        double seconds = secondsSince(&start);
+        printf("dijkstra  %-12s %8.3f s  %6.1f ns/op\n", heaps[h].name, seconds, seconds * 1e9 / pushes);
+    }
+    uint32_t maxDist = 0;
+    for (int v = 0; v < VERTICES; v++) {
+        if (dist[0][v] != UINT32_MAX && dist[0][v] > maxDist) maxDist = dist[0][v];
+    }
+    // The binary heap's int keys hold (distance << 16 | vertex) only below 2^15
+    int same = memcmp(dist[0], dist[1], sizeof(uint32_t) * VERTICES) == 0 && maxDist < (1u << 15);
+    printf("dijkstra  distances %s\n", same ? "match" : "DIFFER");
+
+    // Timers
+    int sizes[] = {1000, 100000, 1000000};
+    for (int s = 0; s < 3; s++) {
+        uint64_t checksums[2];
+        for (int h = 0; h < 2; h++) {
+            struct timespec start;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            checksums[h] = timers(&heaps[h], sizes[s], operations);
+            double seconds = secondsSince(&start);
+            printf("timers %7d %-12s %8.3f s  %6.1f ns/op\n", sizes[s], heaps[h].name, seconds,
+                   seconds * 1e9 / operations);
+        }
+        if (checksums[0] != checksums[1]) {
+            printf("timers %7d expiry order DIFFERS\n", sizes[s]);
+            same = 0;
+        }
+    }
+
+    free(edges);
+    free(dist[0]);
+    free(dist[1]);
+    return same ? 0 : 1;
+}
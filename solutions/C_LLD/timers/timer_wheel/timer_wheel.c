@@ -0,0 +1,360 @@
+/*
+ * Hierarchical timing wheel: timers with O(1) start, stop and restart, and
+ * expiry in batches of one slot per tick.
+ *
+ * - Time is counted in ticks (e.g. 1 ms). `timerAdvance(wheel, now)` fires
+ *   every timer due at or before tick `now`.
+ * - There are WHEEL_LEVELS wheels of WHEEL_SIZE slots. Level 0 has one slot per
+ *   tick. Each slot of level L covers WHEEL_SIZE^L ticks. A timer goes into the
+ *   lowest level whose span covers its distance from the current tick, in the
+ *   slot numbered by the matching bits of its expiry. With 4 levels of 256
+ *   slots, this covers 2^32 ticks. Timers further out wait in the last slot of
+ *   the top level and are placed again when it comes round.
+ * - Each slot is a doubly linked list, so stop only unlinks one node, with no
+ *   search and no comparisons.
+ * - Restarting to a later tick, which is what an idle timeout does on every
+ *   packet, only writes the new expiry into the node. The node stays in its old
+ *   slot, and when that slot comes round the node is placed again according to
+ *   its new expiry. A connection that sees traffic every millisecond costs one
+ *   store per packet and one move per expiry period. Restarting to an earlier
+ *   tick moves the node at once.
+ * - When level 0 wraps, the due slot of level 1 is *cascaded*: its timers are
+ *   placed again relative to the new current tick, and now fall into level 0.
+ *   Level 2 cascades into level 1 when level 1 wraps, and so on. A timer moves
+ *   at most WHEEL_LEVELS - 1 times, and most connection timeouts are stopped or
+ *   restarted before they ever cascade.
+ * - Each tick detaches its level-0 slot in one step and fires the whole list.
+ *   A callback may start, stop or restart any timer, including one later in
+ *   the same batch.
+ * - Timer nodes come from a pool: one array with a free list threaded through
+ *   it, which grows by doubling. Starting and stopping timers does not call
+ *   malloc once the pool is large enough.
+ * - Timers are named by a TimerId holding the node's index and a generation,
+ *   as with the HeapHandle of indexed_heap.c. When a timer fires or is
+ *   stopped, its node's generation changes, so an old TimerId is stale instead
+ *   of naming whatever timer reuses the node.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WHEEL_BITS 8
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 4
+#define WHEEL_RANGE (1ULL << (WHEEL_BITS * WHEEL_LEVELS))   // Ticks covered by the levels
+#define WHEEL_BUCKETS (WHEEL_LEVELS * WHEEL_SIZE)
+#define FIRING_BUCKET WHEEL_BUCKETS     // The batch of the tick being fired
+#define NIL UINT32_MAX
+
+// Low 32 bits: node index; high 32 bits: generation of the node when it was issued.
+// Generations start at 1, so 0 is never a valid id.
+typedef uint64_t TimerId;
+
+#define NO_TIMER 0
+
+typedef void (*TimerCallback)(void *arg);
+
+typedef struct {
+    uint64_t expires;       // Tick at which the timer fires
+    uint32_t next;          // Next node in the bucket (or in the free list)
+    uint32_t prev;
+    uint32_t bucket;        // Bucket holding the node, or NIL if the node is free
+    uint32_t generation;
+    TimerCallback callback;
+    void *arg;
+} TimerNode;
+
+typedef struct {
+    uint32_t heads[WHEEL_BUCKETS + 1];  // One list per slot, plus the firing batch
+    uint64_t occupied[WHEEL_BUCKETS / 64];   // Bit per non-empty slot, to skip idle ticks
+    uint64_t current;       // Next tick to process; no pending timer is due before it
+    TimerNode *nodes;       // The pool
+    uint32_t capacity;
+    uint32_t freeHead;
+    size_t count;           // Pending timers
+} TimerWheel;
+
+// Grow the pool to `capacity` nodes and put the new ones on the free list
+static int growPool(TimerWheel *wheel, uint32_t capacity) {
+    TimerNode *nodes = (TimerNode *)realloc(wheel->nodes, sizeof(TimerNode) * capacity);
+    if (!nodes) return -1;
+    wheel->nodes = nodes;
+    for (uint32_t i = capacity; i-- > wheel->capacity;) {
+        nodes[i].bucket = NIL;
+        nodes[i].generation = 1;
+        nodes[i].next = wheel->freeHead;
+        wheel->freeHead = i;
+    }
+    wheel->capacity = capacity;
+    return 0;
+}
+
+// Function to create a timing wheel whose clock starts at tick `now`, with room
+// for `capacity` timers before the pool grows. Returns NULL if out of memory.
+TimerWheel *createTimerWheel(uint32_t capacity, uint64_t now) {
+    TimerWheel *wheel = (TimerWheel *)calloc(1, sizeof(TimerWheel));
+    if (!wheel) return NULL;
+    for (int i = 0; i <= WHEEL_BUCKETS; i++) wheel->heads[i] = NIL;
+    wheel->current = now + 1;
+    wheel->freeHead = NIL;
+    if (growPool(wheel, capacity > 0 ? capacity : 64) != 0) {
+        free(wheel);
+        return NULL;
+    }
+    return wheel;
+}
+
+// Bucket for a timer due at `expires` (not before wheel->current)
+static uint32_t bucketFor(const TimerWheel *wheel, uint64_t expires) {
+    uint64_t delta = expires - wheel->current;
+    if (delta >= WHEEL_RANGE) {
+        // Too far out: park in the top level's last slot before the current one
+        delta = WHEEL_RANGE - 1;
+        expires = wheel->current + delta;
+    }
+    int level = delta < WHEEL_SIZE ? 0 : (63 - __builtin_clzll(delta)) / WHEEL_BITS;
+    return level * WHEEL_SIZE + ((expires >> (level * WHEEL_BITS)) & WHEEL_MASK);
+}
+
+static void linkNode(TimerWheel *wheel, uint32_t i, uint32_t bucket) {
+    TimerNode *node = &wheel->nodes[i];
+    node->bucket = bucket;
+    node->prev = NIL;
+    node->next = wheel->heads[bucket];
+    if (node->next != NIL) wheel->nodes[node->next].prev = i;
+    wheel->heads[bucket] = i;
+    if (bucket < WHEEL_BUCKETS) wheel->occupied[bucket / 64] |= 1ULL << (bucket % 64);
+}
+
+static void unlinkNode(TimerWheel *wheel, uint32_t i) {
+    TimerNode *node = &wheel->nodes[i];
+    if (node->prev != NIL) {
+        wheel->nodes[node->prev].next = node->next;
+    } else {
+        wheel->heads[node->bucket] = node->next;
+        if (node->next == NIL && node->bucket < WHEEL_BUCKETS)
+            wheel->occupied[node->bucket / 64] &= ~(1ULL << (node->bucket % 64));
+    }
+    if (node->next != NIL) wheel->nodes[node->next].prev = node->prev;
+}
+
+// Empty a bucket and return its list
+static uint32_t detach(TimerWheel *wheel, uint32_t bucket) {
+    uint32_t head = wheel->heads[bucket];
+    wheel->heads[bucket] = NIL;
+    wheel->occupied[bucket / 64] &= ~(1ULL << (bucket % 64));
+    return head;
+}
+
+// Return a node to the pool; ids naming it become stale
+static void release(TimerWheel *wheel, uint32_t i) {
+    TimerNode *node = &wheel->nodes[i];
+    node->bucket = NIL;
+    if (++node->generation == 0) node->generation = 1;
+    node->next = wheel->freeHead;
+    wheel->freeHead = i;
+    wheel->count--;
+}
+
+// Index of a pending timer's node, or NIL if the id is stale or invalid
+static uint32_t nodeOf(const TimerWheel *wheel, TimerId id) {
+    uint32_t i = (uint32_t)id;
+    if (i >= wheel->capacity) return NIL;
+    const TimerNode *node = &wheel->nodes[i];
+    if (node->generation != (uint32_t)(id >> 32) || node->bucket == NIL) return NIL;
+    return i;
+}
+
+static void schedule(TimerWheel *wheel, uint32_t i, uint64_t expires) {
+    if (expires < wheel->current) expires = wheel->current;   // Already due: next tick
+    wheel->nodes[i].expires = expires;
+    linkNode(wheel, i, bucketFor(wheel, expires));
+}
+
+// Function to start a timer that calls `callback(arg)` at tick `now + delay`,
+// where `now` is the tick last passed to timerAdvance (or createTimerWheel).
+// Returns its id, or NO_TIMER if out of memory.
+TimerId timerStart(TimerWheel *wheel, uint64_t delay, TimerCallback callback, void *arg) {
+    if (wheel->freeHead == NIL) {
+        uint32_t capacity = wheel->capacity <= UINT32_MAX / 2 ? wheel->capacity * 2 : UINT32_MAX - 1;
+        if (capacity == wheel->capacity || growPool(wheel, capacity) != 0) return NO_TIMER;
+    }
+    uint32_t i = wheel->freeHead;
+    TimerNode *node = &wheel->nodes[i];
+    wheel->freeHead = node->next;
+    node->callback = callback;
+    node->arg = arg;
+    wheel->count++;
+    schedule(wheel, i, wheel->current - 1 + delay);
+    return (TimerId)node->generation << 32 | i;
+}
+
+// Function to cancel a pending timer. Returns -1 if it already fired or was stopped.
+int timerStop(TimerWheel *wheel, TimerId id) {
+    uint32_t i = nodeOf(wheel, id);
+    if (i == NIL) return -1;
+    unlinkNode(wheel, i);
+    release(wheel, i);
+    return 0;
+}
+
+// Function to move a pending timer to `now + delay`. The id stays valid.
+// Returns -1 if the timer already fired or was stopped.
+int timerRestart(TimerWheel *wheel, TimerId id, uint64_t delay) {
+    uint32_t i = nodeOf(wheel, id);
+    if (i == NIL) return -1;
+    uint64_t expires = wheel->current - 1 + delay;
+    if (expires >= wheel->nodes[i].expires && wheel->nodes[i].bucket != FIRING_BUCKET) {
+        wheel->nodes[i].expires = expires;   // Moved on when its slot comes round
+        return 0;
+    }
+    unlinkNode(wheel, i);
+    schedule(wheel, i, wheel->current - 1 + delay);
+    return 0;
+}
+
+// Nonzero if the timer is still pending
+int timerPending(const TimerWheel *wheel, TimerId id) {
+    return nodeOf(wheel, id) != NIL;
+}
+
+// Place every timer of a bucket again, relative to the current tick
+static void cascade(TimerWheel *wheel, uint32_t bucket) {
+    uint32_t i = detach(wheel, bucket);
+    while (i != NIL) {
+        uint32_t next = wheel->nodes[i].next;
+        linkNode(wheel, i, bucketFor(wheel, wheel->nodes[i].expires));
+        i = next;
+    }
+}
+
+// First non-empty slot of `level` at index `from` or later, or -1
+static int firstOccupied(const TimerWheel *wheel, int level, int from) {
+    for (int slot = from; slot < WHEEL_SIZE; slot = (slot | 63) + 1) {
+        uint64_t bits = wheel->occupied[(level * WHEEL_SIZE + slot) / 64] >> (slot % 64);
+        if (bits) return slot + __builtin_ctzll(bits);
+    }
+    return -1;
+}
+
+// First tick at or after the current one at which a non-empty slot is fired or
+// cascaded, or UINT64_MAX if there is none. Slot s of level L is handled at the
+// ticks whose level-L digit is s and whose lower digits are all zero (level 0
+// at every tick whose low digit is s).
+static uint64_t nextEvent(const TimerWheel *wheel) {
+    uint64_t t = wheel->current;
+    uint64_t best = UINT64_MAX;
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        int shift = level * WHEEL_BITS;
+        uint64_t round = 1ULL << (shift + WHEEL_BITS);
+        uint64_t base = t & ~(round - 1);
+        int index = (int)((t >> shift) & WHEEL_MASK);
+        if (base + ((uint64_t)index << shift) < t) index++;   // This round's turn has passed
+        int slot = index < WHEEL_SIZE ? firstOccupied(wheel, level, index) : -1;
+        if (slot < 0) {
+            slot = firstOccupied(wheel, level, 0);   // Next round
+            if (slot < 0) continue;
+            base += round;
+        }
+        uint64_t tick = base + ((uint64_t)slot << shift);
+        if (tick < best) best = tick;
+    }
+    return best;
+}
+
+// Function to move the clock forward to tick `now`, firing every timer due at
+// or before it, in tick order. Returns the number of timers fired.
+size_t timerAdvance(TimerWheel *wheel, uint64_t now) {
+    size_t fired = 0;
+    while (wheel->current <= now) {
+        // Jump over ticks where nothing is fired or cascaded
+        if (!(wheel->occupied[(wheel->current & WHEEL_MASK) / 64] & 1ULL << (wheel->current & 63))) {
+            uint64_t next = nextEvent(wheel);
+            if (next > now) {
+                wheel->current = now + 1;
+                break;
+            }
+            wheel->current = next;
+        }
+        uint64_t tick = wheel->current;
+        // Level L wraps when the L lowest digits of the tick are all zero
+        for (int level = 1; level < WHEEL_LEVELS; level++) {
+            if ((tick >> ((level - 1) * WHEEL_BITS)) & WHEEL_MASK) break;
+            cascade(wheel, level * WHEEL_SIZE + ((tick >> (level * WHEEL_BITS)) & WHEEL_MASK));
+        }
+
+        // Detach this tick's slot as the firing batch. The clock moves on first,
+        // so timers started by the callbacks land in later ticks.
+        uint32_t slot = (uint32_t)(tick & WHEEL_MASK);
+        uint32_t i = detach(wheel, slot);
+        wheel->heads[FIRING_BUCKET] = i;
+        for (; i != NIL; i = wheel->nodes[i].next) wheel->nodes[i].bucket = FIRING_BUCKET;
+        wheel->current = tick + 1;
+
+        while ((i = wheel->heads[FIRING_BUCKET]) != NIL) {
+            TimerNode *node = &wheel->nodes[i];
+            unlinkNode(wheel, i);
+            if (node->expires > tick) {   // Restarted to a later tick
+                linkNode(wheel, i, bucketFor(wheel, node->expires));
+                continue;
+            }
+            TimerCallback callback = node->callback;
+            void *arg = node->arg;
+            release(wheel, i);
+            fired++;
+            callback(arg);
+        }
+    }
+    return fired;
+}
+
+// Number of pending timers
+size_t timerCount(const TimerWheel *wheel) {
+    return wheel->count;
+}
+
+void freeTimerWheel(TimerWheel *wheel) {
+    free(wheel->nodes);
+    free(wheel);
+}
+
+#ifndef TIMER_WHEEL_NO_MAIN
+static TimerWheel *demoWheel;
+
+static void onTimeout(void *arg) {
+    printf("tick %llu: connection %s timed out\n", (unsigned long long)demoWheel->current - 1,
+           (const char *)arg);
+}
+
+int main() {
+    demoWheel = createTimerWheel(4, 0);   // 1 tick = 1 ms; the pool grows as needed
+    if (!demoWheel) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    // Idle timeouts for five connections
+    const char *connections[] = {"a", "b", "c", "d", "e"};
+    uint64_t timeouts[] = {100, 300, 300, 70000, 5000000000ULL};
+    TimerId ids[5];
+    for (int i = 0; i < 5; i++)
+        ids[i] = timerStart(demoWheel, timeouts[i], onTimeout, (void *)connections[i]);
+
+    timerAdvance(demoWheel, 50);
+    timerRestart(demoWheel, ids[0], 100);   // Traffic on a at tick 50: due at 150 now
+    timerStop(demoWheel, ids[2]);           // c closed normally
+    printf("stop(c) again = %d (already stopped)\n", timerStop(demoWheel, ids[2]));
+
+    size_t fired = timerAdvance(demoWheel, 1000);   // b at 300, a at 150
+    printf("fired %zu by tick 1000, %zu pending\n", fired, timerCount(demoWheel));
+    timerAdvance(demoWheel, 100000);                // d, after two cascades
+    timerAdvance(demoWheel, 5000000000ULL);         // e, beyond the 2^32-tick range
+    printf("pending(a) = %d, pending(e) = %d\n", timerPending(demoWheel, ids[0]),
+           timerPending(demoWheel, ids[4]));
+
+    freeTimerWheel(demoWheel);
+    return 0;
+}
+#endif
@@ -0,0 +1,184 @@
+/*
+ * Benchmark for the timing wheel against a heap of timers, with 10K, 1M and 10M
+ * connection timeouts.
+ *
+ * Explanation:
+ * - The heap is the indexed heap of indexed_heap.c: a min-heap on the expiry
+ *   tick, with handles so that stop (eraseHandle) and restart (updatePriority)
+ *   are O(log n). The plain Heap of binary_heap.c has no handles, and stopping a
+ *   timer there means a linear search, which is hopeless at a million timers.
+ * - Each connection has one idle timeout. After all timers are started, each
+ *   operation picks a random connection. 90% of the time the connection saw
+ *   traffic and its timer is restarted. Otherwise the connection closed and
+ *   reopened, so the timer is stopped and a new one started. The clock moves
+ *   one tick every TICK_OPS operations.
+ * - Timeouts are about twice the time between two operations on the same
+ *   connection, so most timers are restarted or stopped before they fire. A
+ *   connection whose timer fires reconnects and starts a new one.
+ * - Both implementations see the same operations and must fire the same timers
+ *   at the same ticks; a checksum of (connection, tick) over the firings is
+ *   compared.
+ * - Reported: ns per start while filling, and ns per operation in the mixed
+ *   phase (including the expiry work of each tick).
+ *
+ * Build and run:
+ *   gcc -O2 timer_wheel_benchmark.c -o timer_wheel_benchmark
+ *   ./timer_wheel_benchmark [operations per size]
+ */
+
+#define TIMER_WHEEL_NO_MAIN
+#define INDEXED_HEAP_NO_MAIN
+#include "timer_wheel.c"
+#include "../../memory_management/binary_heap/indexed_heap.c"
+
+#include <time.h>
+
+#define TICK_OPS 100
+
+static double secondsSince(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static uint64_t rngState;
+
+static uint64_t nextRandom(void) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+// State shared by both implementations
+static uint64_t *handles;     // Timer of each connection
+static uint64_t now;          // Current tick
+static uint64_t timeout;      // Base idle timeout in ticks
+static long fired;
+static uint64_t checksum;
+
+// One timer interface over both implementations, so the workload is written once
+typedef struct {
+    const char *name;
+    int (*create)(int timers);
+    uint64_t (*start)(int connection, uint64_t delay);
+    void (*stop)(uint64_t handle);
+    void (*restart)(uint64_t handle, uint64_t delay);
+    void (*advance)(void);
+    void (*destroy)(void);
+} TimerOps;
+
+static const TimerOps *active;
+
+// A connection timed out: it reconnects with a new timer. The delay depends only
+// on the connection and the tick, so both implementations re-arm identically.
+static void expired(int connection) {
+    fired++;
+    checksum += (uint64_t)(connection + 1) * now;
+    uint64_t jitter = ((uint64_t)connection * 2654435761u ^ now) % (timeout / 2 + 1);
+    handles[connection] = active->start(connection, timeout + jitter);
+}
+
+static TimerWheel *wheel;
+
+static void wheelExpired(void *arg) { expired((int)(intptr_t)arg); }
+static int wheelCreate(int timers) { return (wheel = createTimerWheel((uint32_t)timers, now)) ? 0 : -1; }
+static uint64_t wheelStart(int connection, uint64_t delay) {
+    return timerStart(wheel, delay, wheelExpired, (void *)(intptr_t)connection);
+}
+static void wheelStop(uint64_t handle) { timerStop(wheel, handle); }
+static void wheelRestart(uint64_t handle, uint64_t delay) { timerRestart(wheel, handle, delay); }
+static void wheelAdvance(void) { timerAdvance(wheel, now); }
+static void wheelDestroy(void) { freeTimerWheel(wheel); }
+
+static IndexedHeap *heap;
+
+static int heapCreate(int timers) { return (heap = createIndexedHeap(timers, MIN_HEAP)) ? 0 : -1; }
+static uint64_t heapStart(int connection, uint64_t delay) {
+    return indexedInsert(heap, (int)(now + delay), connection);
+}
+static void heapStop(uint64_t handle) { eraseHandle(heap, handle); }
+static void heapRestart(uint64_t handle, uint64_t delay) { updatePriority(heap, handle, (int)(now + delay)); }
+static void heapAdvance(void) {
+    int connection;
+    while (heap->count > 0 && heap->entries[0].priority <= (int)now) {
+        indexedExtract(heap, NULL, &connection);
+        expired(connection);
+    }
+}
+static void heapDestroy(void) { freeIndexedHeap(heap); }
+
+static const TimerOps implementations[] = {
+    {"timing wheel", wheelCreate, wheelStart, wheelStop, wheelRestart, wheelAdvance, wheelDestroy},
+    {"indexed heap", heapCreate, heapStart, heapStop, heapRestart, heapAdvance, heapDestroy},
+};
+
+// Run the workload, leaving the firings in `fired` and `checksum`. Returns -1 if
+// out of memory.
+static int run(const TimerOps *ops, int timers, long operations) {
+    active = ops;
+    now = 0;
+    fired = 0;
+    checksum = 0;
+    rngState = 88172645463325252ULL;
+    // About two rounds of operations over all connections before a timer fires
+    timeout = 2 * (uint64_t)timers / TICK_OPS + 1;
+    if (ops->create(timers) != 0) return -1;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int c = 0; c < timers; c++) handles[c] = ops->start(c, timeout + nextRandom() % timeout);
+    double fillSeconds = secondsSince(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < operations; i++) {
+        uint64_t r = nextRandom();
+        int c = (int)(r % (uint64_t)timers);
+        uint64_t delay = timeout + (r >> 40) % (timeout / 2 + 1);
+        if ((r >> 32) % 10 != 0) {
+            ops->restart(handles[c], delay);          // Traffic: push the timeout back
+        } else {
+            ops->stop(handles[c]);                    // Closed and reopened
+            handles[c] = ops->start(c, delay);
+        }
+        if ((i + 1) % TICK_OPS == 0) {
+            now++;
+            ops->advance();
+        }
+    }
+    double mixedSeconds = secondsSince(&start);
+
+    printf("%9d timers  %-13s start %6.1f ns   mixed %6.1f ns/op   fired %ld\n", timers, ops->name,
+           fillSeconds * 1e9 / timers, mixedSeconds * 1e9 / operations, fired);
+    ops->destroy();
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    long operations = argc > 1 ? atol(argv[1]) : 10000000;
+    int sizes[] = {10000, 1000000, 10000000};
+    int same = 1;
+    for (int s = 0; s < 3; s++) {
+        handles = (uint64_t *)malloc(sizeof(uint64_t) * sizes[s]);
+        if (!handles) {
+            fprintf(stderr, "Out of memory\n");
+            return EXIT_FAILURE;
+        }
+        uint64_t checksums[2];
+        long firings[2];
+        for (int i = 0; i < 2; i++) {
+            if (run(&implementations[i], sizes[s], operations) != 0) {
+                fprintf(stderr, "Out of memory\n");
+                return EXIT_FAILURE;
+            }
+            checksums[i] = checksum;
+            firings[i] = fired;
+        }
+        if (checksums[0] != checksums[1] || firings[0] != firings[1]) {
+            printf("%9d timers  firings DIFFER\n", sizes[s]);
+            same = 0;
+        }
+        free(handles);
+    }
+    return same ? 0 : 1;
+}
@@ -0,0 +1,290 @@
+/*
+ * Explanation:
+ *
+ * ConcurrentHashTable Class Template `ConcurrentHashTable<K, V, Hash>`:
+ * - A hash table shared by many threads without an external global mutex.
+ * - The table is striped into a power-of-two number of shards. The top bits of the
+ *   mixed hash pick the shard, the low bits pick the slot inside it, so shards are
+ *   independent tables that never contend with each other.
+ * - `set`/`erase` take the shard's own `std::mutex` and bump its sequence counter to an
+ *   odd value while they modify the shard, and back to even when done.
+ * - `find` takes no lock and performs no read-modify-write. It reads the sequence
+ *   counter, probes the shard, and re-reads the counter; if a writer was active or the
+ *   counter moved, the read is retried (seqlock). Readers therefore only contend on a
+ *   version check, and only with writers of the same shard.
+ * - `get`/`remove` are the throwing wrappers used by `HashTable`.
+ *
+ * Shard Layout:
+ * - Each shard is an open-addressing table with linear probing. Keys, values and slot
+ *   states are stored as `std::atomic` arrays, so optimistic readers never race in the
+ *   C++ memory-model sense, even when they read a slot mid-update and then retry.
+ * - Erased slots become tombstones; when live items plus tombstones pass 3/4 of the
+ *   shard, the writer rebuilds that one shard. Other shards keep serving reads and
+ *   writes during the resize.
+ * - Growing builds a doubled slot array off to the side and publishes it with a single
+ *   pointer store. The replaced array may still be probed by a reader that loaded the
+ *   old pointer, so it is retired rather than freed, and released when the table is
+ *   destroyed. Since shards only ever double, a shard's retired arrays add up to less
+ *   than its current one.
+ * - A shard filled mostly by tombstones is cleaned in place instead, inside one write
+ *   section, so delete-heavy churn does not retire arrays.
+ *
+ * Implementation Details:
+ * - `K` and `V` must be trivially copyable and lock-free as `std::atomic`, which is what
+ *   lets a reader copy them out without a lock (`int -> int` by default).
+ * - Shards are aligned to 64 bytes so that two shards never share a cache line.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept> // for std::runtime_error
+#include <type_traits>
+#include <vector>
+
+#include "hash_map.cpp" // for hash_mix
+
+template <typename K = int, typename V = int, typename Hash = std::hash<K>>
+class ConcurrentHashTable {
+private:
+    static_assert(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value,
+                  "seqlock readers copy keys and values without a lock");
+
+    enum SlotState : uint8_t { EMPTY = 0, FULL = 1, DELETED = 2 };
+
+    struct Slots {
+        size_t capacity;   // Power of two
+        std::unique_ptr<std::atomic<uint8_t>[]> state;
+        std::unique_ptr<std::atomic<K>[]> keys;
+        std::unique_ptr<std::atomic<V>[]> values;
+
+        explicit Slots(size_t n)
+            : capacity(n),
+              state(new std::atomic<uint8_t>[n]),
+              keys(new std::atomic<K>[n]()),
+              values(new std::atomic<V>[n]()) {
+            for (size_t i = 0; i < n; i++) state[i].store(EMPTY, std::memory_order_relaxed);
+        }
+    };
+
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> seq{0};          // Odd while a writer is modifying the shard
+        std::atomic<Slots*> slots{nullptr};
+        std::mutex write_lock;
+        size_t count = 0;                      // Live items, guarded by write_lock
+        size_t used = 0;                       // Live items plus tombstones
+        std::unique_ptr<Slots> current;
+        std::vector<std::unique_ptr<Slots>> retired;
+    };
+
+    static constexpr size_t MIN_SLOTS = 16;
+
+    std::unique_ptr<Shard[]> shards;
+    size_t shard_count;
+    unsigned shard_shift;                      // 64 - log2(shard_count)
+    Hash hasher;
+
+    uint64_t hash_function(const K& key) const {
+        return hash_mix(static_cast<uint64_t>(hasher(key)));
+    }
+
+    Shard& shard_for(uint64_t hash) const {
+        return shards[shard_count == 1 ? 0 : hash >> shard_shift];
+    }
+
+    // Probe for `key`. Returns the slot index or `capacity` when absent.
+    static size_t probe(const Slots& s, const K& key, uint64_t hash) {
+        size_t mask = s.capacity - 1;
+        for (size_t i = hash & mask, n = 0; n < s.capacity; i = (i + 1) & mask, n++) {
+            uint8_t st = s.state[i].load(std::memory_order_relaxed);
+            if (st == EMPTY) break;
+            if (st == FULL && s.keys[i].load(std::memory_order_relaxed) == key) return i;
+        }
+        return s.capacity;
+    }
+
+    void begin_write(Shard& shard) {
+        shard.seq.store(shard.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void end_write(Shard& shard) {
+        shard.seq.store(shard.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    static void insert_fresh(Slots& s, const K& key, const V& value, uint64_t hash) {
+        size_t mask = s.capacity - 1;
+        size_t j = hash & mask;
+        while (s.state[j].load(std::memory_order_relaxed) != EMPTY) j = (j + 1) & mask;
+        s.keys[j].store(key, std::memory_order_relaxed);
+        s.values[j].store(value, std::memory_order_relaxed);
+        s.state[j].store(FULL, std::memory_order_relaxed);
+    }
+
+    // Rebuilds one shard without tombstones. When live items need more room
+    // the shard moves to a doubled array that is published with one pointer
+    // store; the old array stays valid for readers still probing it. When only
+    // tombstones filled the shard it is cleaned in place inside one write
+    // section, and readers of this shard retry until it is done.
+    void resize_shard(Shard& shard) {
+        Slots& old = *shard.current;
+        size_t capacity = old.capacity;
+        while ((shard.count + 1) * 2 > capacity) capacity *= 2;
+
+        if (capacity == old.capacity) {
+            std::vector<std::pair<K, V>> live;
+            live.reserve(shard.count);
+            for (size_t i = 0; i < old.capacity; i++) {
+                if (old.state[i].load(std::memory_order_relaxed) == FULL) {
+                    live.emplace_back(old.keys[i].load(std::memory_order_relaxed),
+                                      old.values[i].load(std::memory_order_relaxed));
+                }
+            }
+            begin_write(shard);
+            for (size_t i = 0; i < old.capacity; i++) old.state[i].store(EMPTY, std::memory_order_relaxed);
+            for (const auto& item : live) insert_fresh(old, item.first, item.second, hash_function(item.first));
+            end_write(shard);
+            shard.used = shard.count;
+            return;
+        }
+
+        std::unique_ptr<Slots> fresh(new Slots(capacity));
+        for (size_t i = 0; i < old.capacity; i++) {
+            if (old.state[i].load(std::memory_order_relaxed) != FULL) continue;
+            K key = old.keys[i].load(std::memory_order_relaxed);
+            insert_fresh(*fresh, key, old.values[i].load(std::memory_order_relaxed), hash_function(key));
+        }
+
+        begin_write(shard);
+        shard.slots.store(fresh.get(), std::memory_order_release);
+        end_write(shard);
+
+        shard.retired.push_back(std::move(shard.current));
+        shard.current = std::move(fresh);
+        shard.used = shard.count;
+    }
+
+public:
+    // `shards_hint` is rounded up to a power of two; `s` is the expected total
+    // number of items and only sizes the initial shard arrays.
+    ConcurrentHashTable(size_t shards_hint = 64, size_t s = 0, const Hash& h = Hash())
+        : shard_count(1), shard_shift(64), hasher(h) {
+        while (shard_count < shards_hint) {
+            shard_count *= 2;
+            shard_shift--;
+        }
+        shards.reset(new Shard[shard_count]);
+
+        size_t per_shard = MIN_SLOTS;
+        while (per_shard * 3 / 4 < s / shard_count) per_shard *= 2;
+        for (size_t i = 0; i < shard_count; i++) {
+            shards[i].current.reset(new Slots(per_shard));
+            shards[i].slots.store(shards[i].current.get(), std::memory_order_release);
+        }
+    }
+
+    // Lock-free read: no lock, no read-modify-write, retries while a writer
+    // holds the same shard.
+    std::optional<V> find(const K& key) const {
+        uint64_t hash = hash_function(key);
+        const Shard& shard = shard_for(hash);
+        for (;;) {
+            uint64_t before = shard.seq.load(std::memory_order_acquire);
+            if (before & 1) continue;
+
+            const Slots* s = shard.slots.load(std::memory_order_acquire);
+            size_t i = probe(*s, key, hash);
+            bool found = i != s->capacity;
+            V value = found ? s->values[i].load(std::memory_order_relaxed) : V();
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (shard.seq.load(std::memory_order_relaxed) == before) {
+                return found ? std::optional<V>(value) : std::nullopt;
+            }
+        }
+    }
+
+    bool contains(const K& key) const {
+        return find(key).has_value();
+    }
+
+    void set(const K& key, const V& value) {
+        uint64_t hash = hash_function(key);
+        Shard& shard = shard_for(hash);
+        std::lock_guard<std::mutex> lock(shard.write_lock);
+
+        Slots* s = shard.current.get();
+        size_t i = probe(*s, key, hash);
+        if (i != s->capacity) {
+            begin_write(shard);
+            s->values[i].store(value, std::memory_order_relaxed);
+            end_write(shard);
+            return;
+        }
+
+        if ((shard.used + 1) * 4 > s->capacity * 3) {
+            resize_shard(shard);
+            s = shard.current.get();
+        }
+
+        // The key is absent, so the first non-FULL slot on its probe path is
+        // free to take, reusing a tombstone when there is one.
+        size_t mask = s->capacity - 1;
+        size_t j = hash & mask;
+        while (s->state[j].load(std::memory_order_relaxed) == FULL) j = (j + 1) & mask;
+        bool reused = s->state[j].load(std::memory_order_relaxed) == DELETED;
+
+        begin_write(shard);
+        s->keys[j].store(key, std::memory_order_relaxed);
+        s->values[j].store(value, std::memory_order_relaxed);
+        s->state[j].store(FULL, std::memory_order_relaxed);
+        end_write(shard);
+
+        shard.count++;
+        if (!reused) shard.used++;
+    }
+
+    // Removes `key`; returns false if it was not present.
+    bool erase(const K& key) {
+        uint64_t hash = hash_function(key);
+        Shard& shard = shard_for(hash);
+        std::lock_guard<std::mutex> lock(shard.write_lock);
+
+        Slots* s = shard.current.get();
+        size_t i = probe(*s, key, hash);
+        if (i == s->capacity) return false;
+
+        begin_write(shard);
+        s->state[i].store(DELETED, std::memory_order_relaxed);
+        end_write(shard);
+        shard.count--;
+        return true;
+    }
+
+    V get(const K& key) const {
+        if (auto value = find(key)) {
+            return *value;
+        }
+        throw std::runtime_error("Key not found");
+    }
+
+    void remove(const K& key) {
+        if (!erase(key)) {
+            throw std::runtime_error("Key not found");
+        }
+    }
+
+    // Sum over shards; exact only when no writer is running.
+    size_t items() const {
+        size_t total = 0;
+        for (size_t i = 0; i < shard_count; i++) {
+            std::lock_guard<std::mutex> lock(shards[i].write_lock);
+            total += shards[i].count;
+        }
+        return total;
+    }
+};
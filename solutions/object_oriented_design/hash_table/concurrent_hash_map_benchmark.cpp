@@ -0,0 +1,143 @@
+/*
+ * Throughput benchmark for ConcurrentHashTable.
+ *
+ * Explanation:
+ * - The table is prefilled with `KEYS` items; each thread then runs a read/write mix for a
+ *   fixed time on uniformly random keys drawn from twice the prefilled key range, so about
+ *   half of the reads miss.
+ * - Writes alternate between `set` and `erase`, which keeps the table size stable.
+ * - Mixes: 95/5 and 50/50 (read% / write%). Thread counts: 1, 2, 4, ..., 64.
+ * - The same runs are repeated for `HashTable` behind one global `std::mutex`, which is the
+ *   setup the concurrent table replaces.
+ * - Reported: total million operations per second and the speedup over one thread.
+ *
+ * Build and run:
+ *   g++ -O2 -std=c++17 -pthread concurrent_hash_map_benchmark.cpp -o concurrent_hash_map_benchmark
+ *   ./concurrent_hash_map_benchmark [milliseconds per run]
+ *
+ * Read scaling only shows up with as many idle cores as threads; above the core count the
+ * numbers measure oversubscription.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "concurrent_hash_map.cpp"
+
+static const int KEYS = 1 << 20;
+static std::atomic<uint64_t> sink(0);   // Read results land here so they are not optimized away
+
+// Small per-thread generator so the RNG does not dominate the measurement.
+struct XorShift {
+    uint64_t state;
+    explicit XorShift(uint64_t seed) : state(seed * 0x9e3779b97f4a7c15ULL + 1) {}
+    uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+// Global-mutex baseline with the same interface as ConcurrentHashTable.
+class LockedHashTable {
+private:
+    HashTable<> table;
+    mutable std::mutex lock;
+
+public:
+    LockedHashTable() : table(KEYS) {}
+
+    bool contains(int key) const {
+        std::lock_guard<std::mutex> guard(lock);
+        return table.contains(key);
+    }
+
+    void set(int key, int value) {
+        std::lock_guard<std::mutex> guard(lock);
+        table.set(key, value);
+    }
+
+    bool erase(int key) {
+        std::lock_guard<std::mutex> guard(lock);
+        return table.erase(key);
+    }
+};
+
+template <typename Table>
+double run(Table& table, int threads, int read_percent, int millis) {
+    std::atomic<bool> start(false), stop(false);
+    std::vector<uint64_t> ops(threads, 0);
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            XorShift rng(t + 1);
+            uint64_t done = 0, hits = 0;
+            while (!start.load(std::memory_order_acquire)) {}
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < 64; i++) {
+                    uint64_t r = rng.next();
+                    int key = static_cast<int>((r >> 8) % (2 * KEYS));
+                    if (static_cast<int>(r % 100) < read_percent) {
+                        hits += table.contains(key);
+                    } else if (r & 0x80) {
+                        table.set(key, key);
+                    } else {
+                        table.erase(key);
+                    }
+                }
+                done += 64;
+            }
+            ops[t] = done;
+            sink.fetch_add(hits, std::memory_order_relaxed);
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& w : workers) w.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    uint64_t total = 0;
+    for (uint64_t n : ops) total += n;
+    return total / seconds / 1e6;
+}
+
+template <typename Table>
+void sweep(const char* name, Table& table, int millis) {
+    for (int read_percent : {95, 50}) {
+        double single = 0;
+        for (int threads = 1; threads <= 64; threads *= 2) {
+            double mops = run(table, threads, read_percent, millis);
+            if (threads == 1) single = mops;
+            printf("%-22s %3d/%-3d %8d %12.2f %9.2fx\n",
+                   name, read_percent, 100 - read_percent, threads, mops, mops / single);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int millis = argc > 1 ? atoi(argv[1]) : 500;
+
+    printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+    printf("%-22s %-7s %8s %12s %10s\n", "table", "mix", "threads", "Mops/s", "speedup");
+
+    ConcurrentHashTable<> sharded(64, KEYS);
+    LockedHashTable locked;
+    for (int i = 0; i < KEYS; i++) {
+        sharded.set(i * 2, i);
+        locked.set(i * 2, i);
+    }
+
+    sweep("ConcurrentHashTable", sharded, millis);
+    sweep("HashTable + mutex", locked, millis);
+    return 0;
+}
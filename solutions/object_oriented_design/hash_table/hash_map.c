@@ -1,7 +1,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifndef TABLE_SIZE
 #define TABLE_SIZE 10
+#endif
 
 // Define the Item structure
 typedef struct Item {
@@ -56,17 +58,27 @@ void set(HashTable *ht, int key, int value) {
     }
 }
 
-// Retrieve the value for a given key
-int get(HashTable *ht, int key) {
+// Look up a key without failing: returns 1 and stores the value if found, 0 otherwise
+int find(HashTable *ht, int key, int *value) {
     int index = hash_function(key);
     Item *current = ht->table[index];
     
     while (current != NULL) {
         if (current->key == key) {
-            return current->value;
+            *value = current->value;
+            return 1;
         }
         current = current->next;
     }
+    return 0;
+}
+
+// Retrieve the value for a given key
+int get(HashTable *ht, int key) {
+    int value;
+    if (find(ht, key, &value)) {
+        return value;
+    }
     
     // Key not found
     fprintf(stderr, "Key not found\n");
@@ -74,7 +86,8 @@ int get(HashTable *ht, int key) {
 }
 
 // Remove an item with the given key from the hash table
-void remove(HashTable *ht, int key) {
+// (named remove_item because <stdio.h> already declares remove)
+void remove_item(HashTable *ht, int key) {
     int index = hash_function(key);
     Item *current = ht->table[index];
     Item *prev = NULL;
@@ -98,6 +111,7 @@ void remove(HashTable *ht, int key) {
     exit(EXIT_FAILURE);
 }
 
+#ifndef HASH_MAP_NO_MAIN
 // Example usage
 int main() {
     HashTable ht;
@@ -109,9 +123,10 @@ int main() {
     printf("Value for key 1: %d\n", get(&ht, 1));
     printf("Value for key 2: %d\n", get(&ht, 2));
     
-    remove(&ht, 1);
+    remove_item(&ht, 1);
     // Uncommenting the following line will cause the program to exit with an error
     // printf("Value for key 1: %d\n", get(&ht, 1));
     
     return 0;
 }
+#endif
@@ -1,79 +1,813 @@
 /*
  * Explanation:
- * 
- * Item Class:
- * - Contains `key` and `value` attributes.
- * - Includes a constructor to initialize these attributes.
- * 
- * HashTable Class:
- * - Constructor: Initializes the hash table with the given size.
- * - `hash_function` Method: Computes the index in the table based on the key.
+ *
+ * Item Class Template:
+ * - Contains `key` and `value` attributes (`int` by default).
+ * - Includes a constructor to initialize these attributes, plus a piecewise one so keys
+ *   and values can be built in place.
+ *
+ * HashTable Class Template `HashTable<K, V, Hash, Eq, Alloc>`:
+ * - All parameters have defaults, so `HashTable h(10)` is still an `int -> int` table.
+ * - Constructor: Initializes the hash table with the given size, rounded up to a power of two.
+ * - `hash_function` Method: Mixes the `Hash` result with `hash_mix` and masks it to a bucket
+ *   index, so negative and sequential keys are spread evenly.
+ * - `find` Method: Returns a pointer to the value, or `nullptr` on a miss. Never throws,
+ *   so misses cost no more than hits. `contains` and `erase` (returns `bool`) likewise.
+ * - `try_emplace` / `insert_or_assign` Methods: Insert with move semantics and return the
+ *   stored value plus whether an insertion happened.
+ * - Heterogeneous lookup: when `Hash` and `Eq` both declare `is_transparent` (for example
+ *   `StringHash` with `std::equal_to<>`), `find`/`contains`/`erase` accept any comparable
+ *   key type, such as `std::string_view` against `std::string` keys, without temporaries.
+ * - `Alloc` is rebound to allocate both the chain nodes and the bucket chunks, so the
+ *   table can sit on a pool allocator.
+ * - `get_many` / `set_many` / `remove_many` Methods: Batched versions of `find`,
+ *   `insert_or_assign` and `erase` that write results into caller-provided arrays. Each
+ *   window of 32 keys is hashed and its buckets and first chain nodes are prefetched
+ *   before any chain is walked, so the cache misses of a batch overlap. No allocation.
+ * - `enable_filter` Method: Adds an optional counting blocked Bloom filter that `set` and
+ *   `remove` keep up to date and every lookup checks first. A key the filter rejects is a
+ *   definite miss that costs one cache line and never walks a chain. The filter supports
+ *   deletion and reports observed and estimated false-positive rates for sizing.
+ * - `for_each` Method: Visits every item, e.g. to write a snapshot (see hash_map_snapshot.cpp).
  * - `set` Method: Adds a new item or updates an existing item in the hash table.
  * - `get` Method: Retrieves the value associated with the specified key.
  *   Throws `std::runtime_error` if the key is not found.
  * - `remove` Method: Removes the item associated with the specified key from the table.
  *   Throws `std::runtime_error` if the key is not found.
- * 
+ * - Growth: when items outnumber buckets, a table twice the size is allocated and the
+ *   old buckets are migrated a few at a time (`REHASH_STEP`) on each insert/erase.
+ *   While a resize is in progress a key lives in its old bucket until that bucket has
+ *   been moved, so lookups check the old table first for unmigrated buckets.
+ * - Buckets are stored in a `BucketArray` of 1024-bucket chunks, allocated when first
+ *   touched and freed as soon as the migration has passed them, so allocating the
+ *   bigger table is itself cheap.
+ *
+ * FlatHashTable Class (open addressing, SwissTable style):
+ * - Same `set`/`get`/`remove` interface and error behaviour as `HashTable`, plus the
+ *   non-throwing `find`/`erase`.
+ * - Keys and values live in one contiguous `slots` array; there is no node per item.
+ * - A parallel `ctrl` array holds one control byte per slot: `EMPTY`, `DELETED`, or
+ *   the low 7 bits of the key's hash (`h2`) when the slot is full.
+ * - Slots are grouped in 16s. A probe loads the 16 control bytes of a group with one
+ *   SSE2 load and compares all of them against `h2` at once; only slots whose byte
+ *   matches are compared by key. A group that still has an `EMPTY` byte ends the probe.
+ * - The upper hash bits (`h1`) pick the first group; further groups follow a
+ *   triangular sequence, which visits every group of a power-of-two table.
+ * - The table grows (doubling) at a 7/8 load factor, and tombstones are purged by
+ *   rehashing in place when they, rather than live items, fill the table.
+ *
  * Implementation Details:
- * - Uses `std::vector` for the table to store the list of items.
+ * - Uses chunked `std::vector` storage for the table to store the list of items.
  * - Uses `std::list` to handle collisions using chaining.
- * - Handles errors with `std::runtime_error` to indicate issues such as key not found.
+ * - `get`/`remove` report a missing key with `std::runtime_error`; use `find`/`erase`
+ *   on paths where misses are common.
+ * - `FlatHashTable` falls back to a scalar loop over the group when SSE2 is unavailable.
  */
 
+#ifndef HASH_MAP_CPP
+#define HASH_MAP_CPP
+
 #include <vector>
 #include <list>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <stdexcept> // for std::runtime_error
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HASH_TABLE_SSE2 1
+#endif
+
+// Finalizer from MurmurHash3: every input bit affects every output bit, so
+// sequential integer keys spread across the whole table.
+inline uint64_t hash_mix(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
 
+template <typename K = int, typename V = int>
 class Item {
 public:
-    int key;
-    int value;
+    K key;
+    V value;
 
-    Item(int k, int v) : key(k), value(v) {}
+    Item(const K& k, const V& v) : key(k), value(v) {}
+
+    template <typename KeyArg, typename... Args>
+    Item(std::piecewise_construct_t, KeyArg&& k, Args&&... args)
+        : key(std::forward<KeyArg>(k)), value(std::forward<Args>(args)...) {}
 };
 
-class HashTable {
+// Hash for `std::string` keys that also accepts `std::string_view` and
+// `const char*`, so lookups by view never build a temporary string.
+struct StringHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view s) const {
+        return std::hash<std::string_view>()(s);
+    }
+};
+
+// Bucket array split into fixed-size chunks that are allocated on first use
+// and freed individually. Growing the table therefore never constructs (or
+// destroys) millions of buckets in one call.
+template <typename Bucket, typename Alloc>
+class BucketArray {
 private:
-    int size;
-    std::vector<std::list<Item>> table;
+    static constexpr size_t CHUNK = 1024;
+
+    using ChunkAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Bucket>;
+    using ChunkTraits = std::allocator_traits<ChunkAlloc>;
+
+    std::vector<Bucket*> chunks;
+    size_t buckets;
+    ChunkAlloc alloc;
 
-    int hash_function(int key) const {
-        return key % size;
+    void free_chunk(size_t c) {
+        if (!chunks[c]) return;
+        for (size_t i = 0; i < CHUNK; i++) ChunkTraits::destroy(alloc, chunks[c] + i);
+        ChunkTraits::deallocate(alloc, chunks[c], CHUNK);
+        chunks[c] = nullptr;
+    }
+
+    void free_all() {
+        for (size_t c = 0; c < chunks.size(); c++) free_chunk(c);
     }
 
 public:
-    HashTable(int s) : size(s), table(s) {}
+    BucketArray(size_t n = 0, const Alloc& a = Alloc())
+        : chunks((n + CHUNK - 1) / CHUNK, nullptr), buckets(n), alloc(a) {}
 
-    void set(int key, int value) {
-        int hash_index = hash_function(key);
-        for (auto& item : table[hash_index]) {
-            if (item.key == key) {
-                item.value = value;
-                return;
+    BucketArray(BucketArray&& other) noexcept
+        : chunks(std::move(other.chunks)), buckets(other.buckets), alloc(other.alloc) {
+        other.chunks.clear();
+        other.buckets = 0;
+    }
+
+    BucketArray& operator=(BucketArray&& other) noexcept {
+        if (this != &other) {
+            free_all();
+            chunks = std::move(other.chunks);
+            buckets = other.buckets;
+            alloc = other.alloc;
+            other.chunks.clear();
+            other.buckets = 0;
+        }
+        return *this;
+    }
+
+    ~BucketArray() { free_all(); }
+
+    size_t size() const { return buckets; }
+
+    Bucket& operator[](size_t i) {
+        Bucket*& chunk = chunks[i / CHUNK];
+        if (!chunk) {
+            chunk = ChunkTraits::allocate(alloc, CHUNK);
+            for (size_t j = 0; j < CHUNK; j++) ChunkTraits::construct(alloc, chunk + j, Alloc(alloc));
+        }
+        return chunk[i % CHUNK];
+    }
+
+    // Read-only access; buckets in a chunk that was never touched are empty.
+    const Bucket* find(size_t i) const {
+        const Bucket* chunk = chunks[i / CHUNK];
+        return chunk ? &chunk[i % CHUNK] : nullptr;
+    }
+
+    // Frees the chunk holding bucket `i` once it is the chunk's last bucket.
+    void release_through(size_t i) {
+        if ((i + 1) % CHUNK == 0 || i + 1 == buckets) free_chunk(i / CHUNK);
+    }
+};
+
+// Counting blocked Bloom filter used by HashTable to answer "definitely not
+// present" without touching the buckets. Every key maps to one 64-byte block
+// (one cache line) of 128 4-bit counters and sets K_PROBES of them, so both a
+// lookup and an update read exactly one line. Counters make deletion possible;
+// a counter that reaches 15 saturates and is never decremented again, which
+// can only cost false positives, never false negatives.
+class NegativeLookupFilter {
+private:
+    static constexpr size_t K_PROBES = 4;
+    static constexpr size_t COUNTERS_PER_BLOCK = 128;
+    static constexpr uint64_t COUNTER_MAX = 15;
+
+    struct alignas(64) Block {
+        uint64_t words[8];   // 16 counters per word
+    };
+
+    std::vector<Block> blocks;
+
+    // Lookup statistics. Updated with plain relaxed load/store rather than a
+    // read-modify-write so concurrent const lookups stay cheap; the totals are
+    // then approximate, which is enough for sizing.
+    mutable std::atomic<uint64_t> lookups{0};
+    mutable std::atomic<uint64_t> rejected{0};
+    mutable std::atomic<uint64_t> false_positives{0};
+
+    static void bump(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // The table indexes buckets with the low bits of `hash`, so the filter
+    // re-mixes it to get independent bits for the block and counter choice.
+    template <typename F>
+    void for_each_counter(uint64_t hash, F f) const {
+        uint64_t mixed = hash_mix(hash ^ 0x9e3779b97f4a7c15ULL);
+        size_t block = static_cast<size_t>(((mixed >> 32) * blocks.size()) >> 32);
+        for (size_t i = 0; i < K_PROBES; i++) {
+            size_t counter = (mixed >> (7 * i)) & (COUNTERS_PER_BLOCK - 1);
+            f(block, counter / 16, (counter % 16) * 4);
+        }
+    }
+
+public:
+    struct Stats {
+        uint64_t lookups;            // Lookups that consulted the filter
+        uint64_t definite_misses;    // Answered by the filter alone
+        uint64_t false_positives;    // Passed the filter but missed in the table
+        double observed_fpr;         // false_positives / all lookups of absent keys
+        double estimated_fpr;        // Predicted from counter occupancy
+        size_t bytes;
+    };
+
+    // Sized for `expected_items` at 16 counters (8 bytes) per item; the
+    // false-positive rate rises as the table outgrows that.
+    explicit NegativeLookupFilter(size_t expected_items)
+        : blocks((expected_items * 16 + COUNTERS_PER_BLOCK - 1) / COUNTERS_PER_BLOCK + 1) {
+        for (auto& block : blocks) {
+            for (auto& word : block.words) word = 0;
+        }
+    }
+
+    void add(uint64_t hash) {
+        for_each_counter(hash, [this](size_t b, size_t w, unsigned shift) {
+            uint64_t& word = blocks[b].words[w];
+            if (((word >> shift) & COUNTER_MAX) != COUNTER_MAX) word += uint64_t(1) << shift;
+        });
+    }
+
+    void remove(uint64_t hash) {
+        for_each_counter(hash, [this](size_t b, size_t w, unsigned shift) {
+            uint64_t& word = blocks[b].words[w];
+            uint64_t c = (word >> shift) & COUNTER_MAX;
+            if (c != 0 && c != COUNTER_MAX) word -= uint64_t(1) << shift;
+        });
+    }
+
+    bool may_contain(uint64_t hash) const {
+        bool maybe = true;
+        for_each_counter(hash, [&](size_t b, size_t w, unsigned shift) {
+            if (((blocks[b].words[w] >> shift) & COUNTER_MAX) == 0) maybe = false;
+        });
+        bump(lookups);
+        if (!maybe) bump(rejected);
+        return maybe;
+    }
+
+    void record_false_positive() const { bump(false_positives); }
+
+    Stats stats() const {
+        uint64_t nonzero = 0;
+        for (const auto& block : blocks) {
+            for (uint64_t word : block.words) {
+                for (unsigned shift = 0; shift < 64; shift += 4) nonzero += ((word >> shift) & COUNTER_MAX) != 0;
             }
         }
-        table[hash_index].emplace_back(key, value);
+        double fill = static_cast<double>(nonzero) / (blocks.size() * COUNTERS_PER_BLOCK);
+        Stats s;
+        s.lookups = lookups.load(std::memory_order_relaxed);
+        s.definite_misses = rejected.load(std::memory_order_relaxed);
+        s.false_positives = false_positives.load(std::memory_order_relaxed);
+        uint64_t absent = s.definite_misses + s.false_positives;
+        s.observed_fpr = absent ? static_cast<double>(s.false_positives) / absent : 0.0;
+        s.estimated_fpr = fill * fill * fill * fill;   // fill^K_PROBES
+        s.bytes = blocks.size() * sizeof(Block);
+        return s;
     }
+};
 
-    int get(int key) const {
-        int hash_index = hash_function(key);
-        for (const auto& item : table[hash_index]) {
-            if (item.key == key) {
-                return item.value;
+template <typename K = int,
+          typename V = int,
+          typename Hash = std::hash<K>,
+          typename Eq = std::equal_to<K>,
+          typename Alloc = std::allocator<Item<K, V>>>
+class HashTable {
+private:
+    using ItemAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Item<K, V>>;
+    using Bucket = std::list<Item<K, V>, ItemAlloc>;
+
+    // Lookups may use a key type other than K only when both functors are
+    // transparent, e.g. `StringHash` with `std::equal_to<>`.
+    template <typename F, typename = void>
+    struct is_transparent : std::false_type {};
+    template <typename F>
+    struct is_transparent<F, std::void_t<typename F::is_transparent>> : std::true_type {};
+
+    template <typename Q>
+    using heterogeneous = std::enable_if_t<is_transparent<Hash>::value && is_transparent<Eq>::value &&
+                                           !std::is_same<std::decay_t<Q>, K>::value, int>;
+
+    static constexpr size_t MIN_BUCKETS = 8;
+    static constexpr size_t REHASH_STEP = 4;   // Old buckets migrated per mutation
+    static constexpr size_t BATCH = 32;        // Keys in flight per prefetch window
+
+    size_t size;                               // Bucket count of `table`, a power of two
+    size_t count;                              // Items across both tables
+    BucketArray<Bucket, ItemAlloc> table;
+    BucketArray<Bucket, ItemAlloc> old_table;  // Non-empty only while a resize is in progress
+    size_t rehash_index;                       // Old buckets below this index are already moved
+    Hash hasher;
+    Eq key_eq;
+    ItemAlloc alloc;
+    std::unique_ptr<NegativeLookupFilter> filter;   // Optional, see enable_filter
+
+    template <typename Q>
+    uint64_t hash_function(const Q& key) const {
+        return hash_mix(static_cast<uint64_t>(hasher(key)));
+    }
+
+    bool rehashing() const { return old_table.size() != 0; }
+
+    // Bucket that currently owns a key: the old one until it has been migrated.
+    Bucket& bucket_for(uint64_t hash) {
+        if (rehashing()) {
+            size_t old_index = hash & (old_table.size() - 1);
+            if (old_index >= rehash_index) return old_table[old_index];
+        }
+        return table[hash & (size - 1)];
+    }
+
+    const Bucket* find_bucket(uint64_t hash) const {
+        if (rehashing()) {
+            size_t old_index = hash & (old_table.size() - 1);
+            if (old_index >= rehash_index) return old_table.find(old_index);
+        }
+        return table.find(hash & (size - 1));
+    }
+
+    // Moves up to `steps` old buckets into the new table. Nodes are spliced,
+    // so migration never allocates or moves items.
+    void rehash_step(size_t steps) {
+        while (steps-- > 0 && rehashing()) {
+            Bucket& bucket = old_table[rehash_index];
+            while (!bucket.empty()) {
+                Bucket& target = table[hash_function(bucket.front().key) & (size - 1)];
+                target.splice(target.end(), bucket, bucket.begin());
+            }
+            old_table.release_through(rehash_index);
+            if (++rehash_index == old_table.size()) {
+                old_table = BucketArray<Bucket, ItemAlloc>(0, alloc);
+                rehash_index = 0;
             }
         }
-        throw std::runtime_error("Key not found");
     }
 
-    void remove(int key) {
-        int hash_index = hash_function(key);
-        auto& bucket = table[hash_index];
+    // Starts a resize once the load factor passes 1. The table doubles and
+    // items move over REHASH_STEP buckets at a time, so no single call pays
+    // for the whole table.
+    void grow_if_needed() {
+        if (count <= size) return;
+        rehash_step(old_table.size());   // Finish any resize still in flight
+        size *= 2;
+        old_table = std::move(table);
+        table = BucketArray<Bucket, ItemAlloc>(size, alloc);
+        rehash_index = 0;
+    }
+
+    template <typename KeyArg, typename... Args>
+    std::pair<V*, bool> emplace_unique(KeyArg&& key, Args&&... args) {
+        rehash_step(REHASH_STEP);
+        uint64_t hash = hash_function(key);
+        return emplace_unique_hashed(std::forward<KeyArg>(key), hash, std::forward<Args>(args)...);
+    }
+
+    // emplace_unique for a key whose hash is already known. Does no migration
+    // work, so the batch paths can run it before prefetching a window.
+    template <typename KeyArg, typename... Args>
+    std::pair<V*, bool> emplace_unique_hashed(KeyArg&& key, uint64_t hash, Args&&... args) {
+        Bucket& bucket = bucket_for(hash);
+        for (auto& item : bucket) {
+            if (key_eq(item.key, key)) {
+                return {&item.value, false};
+            }
+        }
+        bucket.emplace_back(std::piecewise_construct, std::forward<KeyArg>(key), std::forward<Args>(args)...);
+        V* value = &bucket.back().value;
+        if (filter) filter->add(hash);
+        count++;
+        grow_if_needed();
+        return {value, true};
+    }
+
+    template <typename Q>
+    const V* find_hashed(const Q& key, uint64_t hash) const {
+        if (filter && !filter->may_contain(hash)) {
+            return nullptr;
+        }
+        if (const Bucket* bucket = find_bucket(hash)) {
+            for (const auto& item : *bucket) {
+                if (key_eq(item.key, key)) {
+                    return &item.value;
+                }
+            }
+        }
+        if (filter) filter->record_false_positive();
+        return nullptr;
+    }
+
+    template <typename Q>
+    const V* find_item(const Q& key) const {
+        return find_hashed(key, hash_function(key));
+    }
+
+    template <typename Q>
+    bool erase_item(const Q& key) {
+        rehash_step(REHASH_STEP);
+        return erase_hashed(key, hash_function(key));
+    }
+
+    // erase_item for a key whose hash is already known, without migration work
+    template <typename Q>
+    bool erase_hashed(const Q& key, uint64_t hash) {
+        Bucket& bucket = bucket_for(hash);
         for (auto it = bucket.begin(); it != bucket.end(); ++it) {
-            if (it->key == key) {
+            if (key_eq(it->key, key)) {
                 bucket.erase(it);
-                return;
+                if (filter) filter->remove(hash);
+                count--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // First two stages of the batch pipeline for keys[0, n): hash every key
+    // and prefetch its bucket, then prefetch the first node of each bucket.
+    // The misses of the whole window overlap instead of being paid in turn.
+    void prefetch_window(const K* keys, size_t n, uint64_t* hashes) const {
+        const Bucket* buckets[BATCH];
+        for (size_t i = 0; i < n; i++) {
+            hashes[i] = hash_function(keys[i]);
+            buckets[i] = find_bucket(hashes[i]);
+            if (buckets[i]) __builtin_prefetch(buckets[i]);
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (buckets[i] && !buckets[i]->empty()) __builtin_prefetch(&buckets[i]->front());
+        }
+    }
+
+public:
+    HashTable(int s = 0, const Hash& h = Hash(), const Eq& eq = Eq(), const Alloc& a = Alloc())
+        : size(MIN_BUCKETS), count(0), rehash_index(0), hasher(h), key_eq(eq), alloc(a) {
+        while (size < static_cast<size_t>(s > 0 ? s : 0)) size *= 2;
+        table = BucketArray<Bucket, ItemAlloc>(size, alloc);
+        old_table = BucketArray<Bucket, ItemAlloc>(0, alloc);
+    }
+
+    // Returns the value stored for `key`, or nullptr on a miss. The pointer
+    // stays valid until that key is erased; resizing never moves items.
+    V* find(const K& key) { return const_cast<V*>(find_item(key)); }
+    const V* find(const K& key) const { return find_item(key); }
+
+    template <typename Q, heterogeneous<Q> = 0>
+    V* find(const Q& key) { return const_cast<V*>(find_item(key)); }
+    template <typename Q, heterogeneous<Q> = 0>
+    const V* find(const Q& key) const { return find_item(key); }
+
+    bool contains(const K& key) const { return find_item(key) != nullptr; }
+
+    template <typename Q, heterogeneous<Q> = 0>
+    bool contains(const Q& key) const { return find_item(key) != nullptr; }
+
+    // Constructs the value from `args` only if `key` is absent. Returns the
+    // stored value and whether an insertion happened.
+    template <typename... Args>
+    std::pair<V*, bool> try_emplace(const K& key, Args&&... args) {
+        return emplace_unique(key, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    std::pair<V*, bool> try_emplace(K&& key, Args&&... args) {
+        return emplace_unique(std::move(key), std::forward<Args>(args)...);
+    }
+
+    template <typename M>
+    std::pair<V*, bool> insert_or_assign(const K& key, M&& value) {
+        auto result = emplace_unique(key, std::forward<M>(value));
+        if (!result.second) *result.first = std::forward<M>(value);
+        return result;
+    }
+
+    template <typename M>
+    std::pair<V*, bool> insert_or_assign(K&& key, M&& value) {
+        auto result = emplace_unique(std::move(key), std::forward<M>(value));
+        if (!result.second) *result.first = std::forward<M>(value);
+        return result;
+    }
+
+    // Removes `key`; returns false if it was not present.
+    bool erase(const K& key) { return erase_item(key); }
+
+    template <typename Q, heterogeneous<Q> = 0>
+    bool erase(const Q& key) { return erase_item(key); }
+
+    // Batched lookups for n keys. out[i] receives the value pointer for
+    // keys[i], or nullptr on a miss. Keys are processed in windows of BATCH:
+    // all hashes and bucket prefetches of a window are issued before any
+    // chain is walked. Nothing is allocated.
+    void get_many(const K* keys, size_t n, const V** out) const {
+        uint64_t hashes[BATCH];
+        for (size_t base = 0; base < n; base += BATCH) {
+            size_t m = n - base < BATCH ? n - base : BATCH;
+            prefetch_window(keys + base, m, hashes);
+            for (size_t i = 0; i < m; i++) {
+                out[base + i] = find_hashed(keys[base + i], hashes[i]);
+            }
+        }
+    }
+
+    // Batched insert_or_assign of keys[i] -> values[i]. Each key is hashed
+    // once, by prefetch_window. The migration work of the whole window runs
+    // before its prefetches, so it cannot move buckets that were just fetched.
+    void set_many(const K* keys, const V* values, size_t n) {
+        uint64_t hashes[BATCH];
+        for (size_t base = 0; base < n; base += BATCH) {
+            size_t m = n - base < BATCH ? n - base : BATCH;
+            rehash_step(REHASH_STEP * m);
+            prefetch_window(keys + base, m, hashes);
+            for (size_t i = 0; i < m; i++) {
+                auto result = emplace_unique_hashed(keys[base + i], hashes[i], values[base + i]);
+                if (!result.second) *result.first = values[base + i];
+            }
+        }
+    }
+
+    // Batched erase. removed[i] (if `removed` is not null) reports whether
+    // keys[i] was present. Hashing and migration as in set_many.
+    void remove_many(const K* keys, size_t n, bool* removed = nullptr) {
+        uint64_t hashes[BATCH];
+        for (size_t base = 0; base < n; base += BATCH) {
+            size_t m = n - base < BATCH ? n - base : BATCH;
+            rehash_step(REHASH_STEP * m);
+            prefetch_window(keys + base, m, hashes);
+            for (size_t i = 0; i < m; i++) {
+                bool erased = erase_hashed(keys[base + i], hashes[i]);
+                if (removed) removed[base + i] = erased;
+            }
+        }
+    }
+
+    void set(const K& key, const V& value) {
+        insert_or_assign(key, value);
+    }
+
+    const V& get(const K& key) const {
+        if (const V* value = find(key)) {
+            return *value;
+        }
+        throw std::runtime_error("Key not found");
+    }
+
+    void remove(const K& key) {
+        if (!erase(key)) {
+            throw std::runtime_error("Key not found");
+        }
+    }
+
+    size_t items() const { return count; }
+
+    // Puts a NegativeLookupFilter sized for `expected_items` in front of
+    // every lookup (including `get` and `get_many`), so most misses are
+    // answered from one cache line. Existing items are added to it.
+    void enable_filter(size_t expected_items) {
+        filter.reset(new NegativeLookupFilter(expected_items));
+        for_each([this](const K& key, const V&) { filter->add(hash_function(key)); });
+    }
+
+    void disable_filter() { filter.reset(); }
+
+    // Filter statistics, or nullptr when no filter is enabled.
+    const NegativeLookupFilter* lookup_filter() const { return filter.get(); }
+
+    // Visits every item as f(key, value), in no particular order.
+    template <typename F>
+    void for_each(F f) const {
+        for (const auto* buckets : {&old_table, &table}) {
+            for (size_t i = 0; i < buckets->size(); i++) {
+                if (const Bucket* bucket = buckets->find(i)) {
+                    for (const auto& item : *bucket) f(item.key, item.value);
+                }
+            }
+        }
+    }
+};
+
+// One group of 16 control bytes, compared in a single SSE2 instruction.
+class CtrlGroup {
+public:
+    static constexpr size_t WIDTH = 16;
+
+    explicit CtrlGroup(const int8_t* ctrl) {
+#ifdef HASH_TABLE_SSE2
+        bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+        for (size_t i = 0; i < WIDTH; i++) bytes[i] = ctrl[i];
+#endif
+    }
+
+    // Bit i is set when control byte i equals `h2`.
+    uint32_t match(int8_t h2) const {
+#ifdef HASH_TABLE_SSE2
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(h2))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < WIDTH; i++) if (bytes[i] == h2) mask |= 1u << i;
+        return mask;
+#endif
+    }
+
+    // EMPTY and DELETED both have the sign bit set; full slots never do.
+    uint32_t match_empty_or_deleted() const {
+#ifdef HASH_TABLE_SSE2
+        return static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < WIDTH; i++) if (bytes[i] < 0) mask |= 1u << i;
+        return mask;
+#endif
+    }
+
+private:
+#ifdef HASH_TABLE_SSE2
+    __m128i bytes;
+#else
+    int8_t bytes[WIDTH];
+#endif
+};
+
+class FlatHashTable {
+private:
+    static constexpr int8_t EMPTY = -128;   // 0b10000000
+    static constexpr int8_t DELETED = -2;   // 0b11111110
+
+    struct Slot {
+        int key;
+        int value;
+    };
+
+    std::vector<int8_t> ctrl;
+    std::vector<Slot> slots;
+    size_t capacity;      // Always a multiple of CtrlGroup::WIDTH and a power of two
+    size_t count;         // Live items
+    size_t growth_left;   // EMPTY slots that may still be filled before a rehash
+
+    static size_t h1(uint64_t hash) { return static_cast<size_t>(hash >> 7); }
+    static int8_t h2(uint64_t hash) { return static_cast<int8_t>(hash & 0x7f); }
+
+    static size_t next_index(uint32_t& mask) {
+        size_t bit = static_cast<size_t>(__builtin_ctz(mask));
+        mask &= mask - 1;
+        return bit;
+    }
+
+    size_t group_mask() const { return capacity / CtrlGroup::WIDTH - 1; }
+
+    // Returns the slot holding `key`, or `capacity` if it is absent.
+    size_t find_slot(int key) const {
+        uint64_t hash = hash_mix(static_cast<uint64_t>(key));
+        size_t group = h1(hash) & group_mask();
+        for (size_t step = 1;; step++) {
+            size_t base = group * CtrlGroup::WIDTH;
+            CtrlGroup g(&ctrl[base]);
+            for (uint32_t mask = g.match(h2(hash)); mask != 0;) {
+                size_t i = base + next_index(mask);
+                if (slots[i].key == key) return i;
             }
+            if (g.match(EMPTY) != 0) return capacity;
+            group = (group + step) & group_mask();
+        }
+    }
+
+    // First EMPTY or DELETED slot on `key`'s probe sequence.
+    size_t find_insert_slot(uint64_t hash) const {
+        size_t group = h1(hash) & group_mask();
+        for (size_t step = 1;; step++) {
+            size_t base = group * CtrlGroup::WIDTH;
+            uint32_t mask = CtrlGroup(&ctrl[base]).match_empty_or_deleted();
+            if (mask != 0) return base + next_index(mask);
+            group = (group + step) & group_mask();
+        }
+    }
+
+    void reset_growth_left() {
+        growth_left = capacity - capacity / 8 - count;
+    }
+
+    void rehash(size_t new_capacity) {
+        std::vector<int8_t> old_ctrl(new_capacity, EMPTY);
+        std::vector<Slot> old_slots(new_capacity);
+        old_ctrl.swap(ctrl);
+        old_slots.swap(slots);
+        capacity = new_capacity;
+
+        for (size_t i = 0; i < old_ctrl.size(); i++) {
+            if (old_ctrl[i] < 0) continue;
+            uint64_t hash = hash_mix(static_cast<uint64_t>(old_slots[i].key));
+            size_t target = find_insert_slot(hash);
+            ctrl[target] = h2(hash);
+            slots[target] = old_slots[i];
+        }
+        reset_growth_left();
+    }
+
+    // Called when no EMPTY slot may be consumed. Tombstone-heavy tables are
+    // cleaned at the same size; genuinely full ones double.
+    void make_room() {
+        if (count < (capacity - capacity / 8) / 2) {
+            rehash(capacity);
+        } else {
+            rehash(capacity * 2);
+        }
+    }
+
+public:
+    FlatHashTable(int s) : count(0) {
+        capacity = CtrlGroup::WIDTH;
+        while (capacity - capacity / 8 < static_cast<size_t>(s > 0 ? s : 0)) capacity *= 2;
+        ctrl.assign(capacity, EMPTY);
+        slots.resize(capacity);
+        reset_growth_left();
+    }
+
+    void set(int key, int value) {
+        size_t i = find_slot(key);
+        if (i != capacity) {
+            slots[i].value = value;
+            return;
+        }
+
+        uint64_t hash = hash_mix(static_cast<uint64_t>(key));
+        size_t target = find_insert_slot(hash);
+        if (ctrl[target] == EMPTY && growth_left == 0) {
+            make_room();
+            target = find_insert_slot(hash);
+        }
+        if (ctrl[target] == EMPTY) growth_left--;
+        ctrl[target] = h2(hash);
+        slots[target] = Slot{key, value};
+        count++;
+    }
+
+    // Non-throwing lookup, as in HashTable: nullptr on a miss.
+    const int* find(int key) const {
+        size_t i = find_slot(key);
+        return i == capacity ? nullptr : &slots[i].value;
+    }
+
+    int get(int key) const {
+        if (const int* value = find(key)) {
+            return *value;
         }
         throw std::runtime_error("Key not found");
     }
+
+    // Removes `key`; returns false if it was not present.
+    bool erase(int key) {
+        size_t i = find_slot(key);
+        if (i == capacity) {
+            return false;
+        }
+        // If the group still has an EMPTY byte, no probe ever continued past
+        // it, so the slot can go straight back to EMPTY instead of a tombstone.
+        size_t base = i & ~(CtrlGroup::WIDTH - 1);
+        if (CtrlGroup(&ctrl[base]).match(EMPTY) != 0) {
+            ctrl[i] = EMPTY;
+            growth_left++;
+        } else {
+            ctrl[i] = DELETED;
+        }
+        count--;
+        return true;
+    }
+
+    void remove(int key) {
+        if (!erase(key)) {
+            throw std::runtime_error("Key not found");
+        }
+    }
+
+    size_t items() const { return count; }
 };
+
+#endif // HASH_MAP_CPP
@@ -0,0 +1,346 @@
+/*
+ * Benchmark for the hash maps in this repository.
+ *
+ * Explanation:
+ * - Implementations: `HashTable` and `FlatHashTable` (hash_map.cpp), the C `HashTable`
+ *   (object_oriented_design/hash_table/hash_map.c), the C `HashMap`
+ *   (C_LLD/data_structures/hash_map/hash_map.c) and `std::unordered_map` as a reference.
+ *   The C maps are reached through hash_map_benchmark_c.c.
+ * - Table sizes: number of entries chosen so that, at roughly 32 bytes per entry, the table
+ *   fits L1, L2, the last-level cache, or is 10x the last-level cache. Cache sizes come from
+ *   sysconf, with 32 KB / 1 MB / 32 MB as fallbacks.
+ * - Lookup workloads: uniform and Zipfian (theta 0.99, hot keys scattered) over random keys,
+ *   and sequential access over sequential keys. Each runs at 100%, 50% and 0% hit ratio;
+ *   misses use keys that were never inserted.
+ * - Churn workload: delete-heavy steady state; every operation erases the oldest key and
+ *   inserts a new one, so the table size stays constant.
+ * - Reported per run: ns/op (from an untimed-per-op loop), p50 and p99 latency (from timing
+ *   every operation of a second pass, minus the measured clock overhead), and heap bytes
+ *   per entry (glibc `mallinfo2` before and after the fill).
+ * - Results are printed as a table and written as JSON (one record per run) so releases
+ *   can be compared.
+ *
+ * Build and run:
+ *   gcc -O2 -c hash_map_benchmark_c.c -o hash_map_benchmark_c.o
+ *   g++ -O2 -std=c++17 hash_map_benchmark.cpp hash_map_benchmark_c.o -o hash_map_benchmark
+ *   ./hash_map_benchmark [--ops N] [--max-entries N] [--json FILE]
+ *
+ * The C maps have a fixed, compile-time bucket count (`TABLE_SIZE`, 2^20 by default in
+ * hash_map_benchmark_c.c); past that size their chains grow linearly.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "hash_map.cpp"
+
+extern "C" {
+long bench_c_table_size(void);
+void* bench_oop_create(void);
+void bench_oop_set(void* ht, int key, int value);
+int bench_oop_find(void* ht, int key, int* value);
+int bench_oop_remove(void* ht, int key);
+void bench_oop_destroy(void* ht);
+void* bench_lld_create(void);
+void bench_lld_set(void* map, int key, int value);
+int bench_lld_find(void* map, int key, int* value);
+int bench_lld_remove(void* map, int key);
+void bench_lld_destroy(void* map);
+}
+
+// Uniform interface: set, lookup (non-throwing), erase.
+struct StdMap {
+    std::unordered_map<int, int> map;
+    void set(int k, int v) { map[k] = v; }
+    bool lookup(int k, int& v) const {
+        auto it = map.find(k);
+        if (it == map.end()) return false;
+        v = it->second;
+        return true;
+    }
+    bool erase(int k) { return map.erase(k) != 0; }
+};
+
+struct ChainedMap {
+    HashTable<> map;
+    void set(int k, int v) { map.set(k, v); }
+    bool lookup(int k, int& v) const {
+        const int* p = map.find(k);
+        if (p) v = *p;
+        return p != nullptr;
+    }
+    bool erase(int k) { return map.erase(k); }
+};
+
+struct FlatMap {
+    FlatHashTable map{0};
+    void set(int k, int v) { map.set(k, v); }
+    bool lookup(int k, int& v) const {
+        const int* p = map.find(k);
+        if (p) v = *p;
+        return p != nullptr;
+    }
+    bool erase(int k) { return map.erase(k); }
+};
+
+struct OopCMap {
+    void* map = bench_oop_create();
+    ~OopCMap() { bench_oop_destroy(map); }
+    void set(int k, int v) { bench_oop_set(map, k, v); }
+    bool lookup(int k, int& v) const { return bench_oop_find(map, k, &v); }
+    bool erase(int k) { return bench_oop_remove(map, k); }
+};
+
+struct LldCMap {
+    void* map = bench_lld_create();
+    ~LldCMap() { bench_lld_destroy(map); }
+    void set(int k, int v) { bench_lld_set(map, k, v); }
+    bool lookup(int k, int& v) const { return bench_lld_find(map, k, &v); }
+    bool erase(int k) { return bench_lld_remove(map, k); }
+};
+
+struct Result {
+    std::string impl, workload, distribution, size_label;
+    size_t entries;
+    double hit_ratio, ns_per_op, p50_ns, p99_ns, bytes_per_entry;
+};
+
+static size_t heap_in_use() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+// Distinct non-negative keys: i -> i * odd is a bijection modulo 2^31.
+static int scatter(uint32_t i) {
+    return static_cast<int>((i * 2654435761u) & 0x7fffffffu);
+}
+
+struct Rng {
+    uint64_t state;
+    explicit Rng(uint64_t seed) : state(seed) {}
+    uint64_t next() { return hash_mix(++state); }
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+// Zipfian ranks in [0, n) as in YCSB (Gray et al.), rank 0 hottest.
+class Zipf {
+public:
+    Zipf(size_t n, double theta) : n(n), theta(theta) {
+        double zeta2 = 1.0 + std::pow(0.5, theta);
+        zetan = 0;
+        for (size_t i = 1; i <= n; i++) zetan += 1.0 / std::pow(static_cast<double>(i), theta);
+        alpha = 1.0 / (1.0 - theta);
+        eta = (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+    }
+
+    size_t next(Rng& rng) const {
+        double u = rng.uniform();
+        double uz = u * zetan;
+        if (uz < 1.0) return 0;
+        if (uz < 1.0 + std::pow(0.5, theta)) return 1;
+        size_t r = static_cast<size_t>(n * std::pow(eta * u - eta + 1.0, alpha));
+        return r < n ? r : n - 1;
+    }
+
+private:
+    size_t n;
+    double theta, zetan, alpha, eta;
+};
+
+static double clock_overhead_ns() {
+    std::vector<double> samples;
+    for (int i = 0; i < 10000; i++) {
+        auto t0 = std::chrono::steady_clock::now();
+        auto t1 = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+static double overhead_ns = 0;
+static volatile long sink = 0;
+
+static double percentile(std::vector<double>& v, double p) {
+    size_t i = static_cast<size_t>(p * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + i, v.end());
+    return std::max(0.0, v[i] - overhead_ns);
+}
+
+// Times `op(i)` for i in [0, ops): once as a plain loop, once per operation.
+template <typename Op>
+static void measure(size_t ops, Op op, double& ns_per_op, double& p50, double& p99) {
+    long acc = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ops; i++) acc += op(i);
+    auto t1 = std::chrono::steady_clock::now();
+    ns_per_op = std::chrono::duration<double, std::nano>(t1 - t0).count() / ops;
+
+    size_t samples = std::min<size_t>(ops, 200000);
+    std::vector<double> lat(samples);
+    for (size_t i = 0; i < samples; i++) {
+        auto s = std::chrono::steady_clock::now();
+        acc += op(i);
+        lat[i] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - s).count();
+    }
+    p50 = percentile(lat, 0.50);
+    p99 = percentile(lat, 0.99);
+    sink = sink + acc;
+}
+
+struct Config {
+    size_t ops = 1000000;
+    size_t max_entries = 0;   // 0: no cap
+    std::string json = "hash_map_benchmark.json";
+};
+
+template <typename Map>
+static void bench_impl(const char* name, const std::string& size_label, size_t n, const Config& cfg,
+                       std::vector<Result>& out) {
+    const double hit_ratios[] = {1.0, 0.5, 0.0};
+    Rng rng(n);
+
+    // Random keys: uniform and Zipfian lookups
+    {
+        std::vector<int> keys(n);
+        for (size_t i = 0; i < n; i++) keys[i] = scatter(static_cast<uint32_t>(i));
+        size_t before = heap_in_use();
+        std::unique_ptr<Map> map(new Map());
+        for (size_t i = 0; i < n; i++) map->set(keys[i], static_cast<int>(i));
+        double bytes = static_cast<double>(heap_in_use() - before) / n;
+
+        Zipf zipf(n, 0.99);
+        for (const char* dist : {"uniform", "zipfian"}) {
+            for (double hit : hit_ratios) {
+                std::vector<int> queries(cfg.ops);
+                for (size_t i = 0; i < cfg.ops; i++) {
+                    size_t rank = std::strcmp(dist, "uniform") == 0 ? rng.next() % n : zipf.next(rng);
+                    bool want_hit = rng.uniform() < hit;
+                    // Keys scatter(n..2n) were never inserted
+                    queries[i] = want_hit ? keys[rank] : scatter(static_cast<uint32_t>(n + rank));
+                }
+                Result r{name, "lookup", dist, size_label, n, hit, 0, 0, 0, bytes};
+                measure(cfg.ops, [&](size_t i) { int v = 0; return map->lookup(queries[i], v) ? v : 0; },
+                        r.ns_per_op, r.p50_ns, r.p99_ns);
+                out.push_back(r);
+            }
+        }
+
+        // Delete-heavy churn: erase the oldest key, insert a fresh one
+        Result r{name, "churn", "fifo", size_label, n, 1.0, 0, 0, 0, bytes};
+        size_t next_key = 2 * n, oldest = 0;
+        std::vector<int> window(keys);
+        measure(cfg.ops, [&](size_t) {
+            size_t slot = oldest++ % n;
+            map->erase(window[slot]);
+            window[slot] = scatter(static_cast<uint32_t>(next_key++));
+            map->set(window[slot], 1);
+            return 1;
+        }, r.ns_per_op, r.p50_ns, r.p99_ns);
+        out.push_back(r);
+    }
+
+    // Sequential keys, visited in order
+    {
+        size_t before = heap_in_use();
+        std::unique_ptr<Map> map(new Map());
+        for (size_t i = 0; i < n; i++) map->set(static_cast<int>(i), static_cast<int>(i));
+        double bytes = static_cast<double>(heap_in_use() - before) / n;
+        for (double hit : hit_ratios) {
+            Result r{name, "lookup", "sequential", size_label, n, hit, 0, 0, 0, bytes};
+            std::vector<char> miss(cfg.ops);
+            for (size_t i = 0; i < cfg.ops; i++) miss[i] = rng.uniform() >= hit;
+            measure(cfg.ops, [&](size_t i) {
+                int key = static_cast<int>(i % n + (miss[i] ? n : 0));
+                int v = 0;
+                return map->lookup(key, v) ? v : 0;
+            }, r.ns_per_op, r.p50_ns, r.p99_ns);
+            out.push_back(r);
+        }
+    }
+
+    fprintf(stderr, "  done: %s %s\n", name, size_label.c_str());
+}
+
+static long cache_size(int name, long fallback) {
+    long v = sysconf(name);
+    return v > 0 ? v : fallback;
+}
+
+static void write_json(const Config& cfg, const std::vector<Result>& results) {
+    FILE* f = fopen(cfg.json.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "Cannot write %s\n", cfg.json.c_str());
+        return;
+    }
+    fprintf(f, "{\n  \"benchmark\": \"hash_map\",\n  \"ops_per_run\": %zu,\n  \"c_table_size\": %ld,\n",
+            cfg.ops, bench_c_table_size());
+    fprintf(f, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        fprintf(f,
+                "    {\"impl\": \"%s\", \"workload\": \"%s\", \"distribution\": \"%s\", \"size\": \"%s\", "
+                "\"entries\": %zu, \"hit_ratio\": %.2f, \"ns_per_op\": %.2f, \"p50_ns\": %.1f, "
+                "\"p99_ns\": %.1f, \"bytes_per_entry\": %.1f}%s\n",
+                r.impl.c_str(), r.workload.c_str(), r.distribution.c_str(), r.size_label.c_str(), r.entries,
+                r.hit_ratio, r.ns_per_op, r.p50_ns, r.p99_ns, r.bytes_per_entry, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+}
+
+int main(int argc, char* argv[]) {
+    Config cfg;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--ops")) cfg.ops = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--max-entries")) cfg.max_entries = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--json")) cfg.json = argv[i + 1];
+    }
+
+    long l1 = cache_size(_SC_LEVEL1_DCACHE_SIZE, 32 << 10);
+    long l2 = cache_size(_SC_LEVEL2_CACHE_SIZE, 1 << 20);
+    long llc = cache_size(_SC_LEVEL3_CACHE_SIZE, 32 << 20);
+    std::vector<std::pair<std::string, size_t>> sizes = {
+        {"L1", l1 / 32}, {"L2", l2 / 32}, {"LLC", llc / 32}, {"10xLLC", 10 * llc / 32}};
+
+    overhead_ns = clock_overhead_ns();
+    fprintf(stderr, "caches: L1 %ld, L2 %ld, LLC %ld bytes; clock overhead %.1f ns\n", l1, l2, llc, overhead_ns);
+
+    std::vector<Result> results;
+    for (const auto& size : sizes) {
+        size_t n = cfg.max_entries ? std::min(size.second, cfg.max_entries) : size.second;
+        bench_impl<StdMap>("std::unordered_map", size.first, n, cfg, results);
+        bench_impl<ChainedMap>("HashTable", size.first, n, cfg, results);
+        bench_impl<FlatMap>("FlatHashTable", size.first, n, cfg, results);
+        bench_impl<OopCMap>("C HashTable", size.first, n, cfg, results);
+        bench_impl<LldCMap>("C_LLD HashMap", size.first, n, cfg, results);
+    }
+
+    printf("%-19s %-7s %-7s %-10s %9s %5s %9s %8s %8s %8s\n",
+           "impl", "size", "work", "dist", "entries", "hit", "ns/op", "p50", "p99", "B/entry");
+    for (const auto& r : results) {
+        printf("%-19s %-7s %-7s %-10s %9zu %5.2f %9.1f %8.1f %8.1f %8.1f\n",
+               r.impl.c_str(), r.size_label.c_str(), r.workload.c_str(), r.distribution.c_str(), r.entries,
+               r.hit_ratio, r.ns_per_op, r.p50_ns, r.p99_ns, r.bytes_per_entry);
+    }
+
+    write_json(cfg, results);
+    return 0;
+}
@@ -0,0 +1,86 @@
+/*
+ * C side of hash_map_benchmark.cpp.
+ *
+ * Compiles both C hash maps into one translation unit (without their example
+ * main functions) and exposes them through prefixed wrappers that C++ can call.
+ * This is needed because the C_LLD map names a function `delete`, which is a
+ * C++ keyword.
+ *
+ * Both maps have a compile-time bucket count; it is set here with TABLE_SIZE,
+ * and reported by bench_c_table_size().
+ */
+
+#ifndef TABLE_SIZE
+#define TABLE_SIZE (1 << 20)
+#endif
+#define HASH_MAP_NO_MAIN
+
+#include "hash_map.c"
+#include "../../C_LLD/data_structures/hash_map/hash_map.c"
+
+long bench_c_table_size(void) { return TABLE_SIZE; }
+
+/* object_oriented_design/hash_table/hash_map.c */
+
+void *bench_oop_create(void) {
+    HashTable *ht = (HashTable *)malloc(sizeof(HashTable));
+    init_hash_table(ht);
+    return ht;
+}
+
+void bench_oop_set(void *ht, int key, int value) { set((HashTable *)ht, key, value); }
+
+int bench_oop_find(void *ht, int key, int *value) { return find((HashTable *)ht, key, value); }
+
+int bench_oop_remove(void *ht, int key) {
+    int value;
+    if (!find((HashTable *)ht, key, &value)) {
+        return 0;  // remove_item exits on a missing key
+    }
+    remove_item((HashTable *)ht, key);
+    return 1;
+}
+
+void bench_oop_destroy(void *ht) {
+    HashTable *table = (HashTable *)ht;
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        Item *current = table->table[i];
+        while (current != NULL) {
+            Item *next = current->next;
+            free(current);
+            current = next;
+        }
+    }
+    free(table);
+}
+
+/* C_LLD/data_structures/hash_map/hash_map.c */
+
+void *bench_lld_create(void) {
+    HashMap *map = (HashMap *)malloc(sizeof(HashMap));
+    initializeHashMap(map);
+    return map;
+}
+
+void bench_lld_set(void *map, int key, int value) { insert((HashMap *)map, key, value); }
+
+int bench_lld_find(void *map, int key, int *value) {
+    int found = search((HashMap *)map, key);
+    *value = found;
+    return found != -1;  // The map reports a miss as -1; benchmark values are never negative
+}
+
+int bench_lld_remove(void *map, int key) { return delete((HashMap *)map, key); }
+
+void bench_lld_destroy(void *map) {
+    HashMap *hm = (HashMap *)map;
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        Node *current = hm->table[i];
+        while (current != NULL) {
+            Node *next = current->next;
+            free(current);
+            current = next;
+        }
+    }
+    free(hm);
+}
@@ -0,0 +1,343 @@
+/*
+ * Read-copy-update (RCU) version of the HashTable in hash_map.c.
+ *
+ * Explanation:
+ * - One or more updater threads call ht_set/ht_remove; they are serialized by a
+ *   mutex. Any number of reader threads call ht_get, which takes no lock and does
+ *   no atomic read-modify-write: it only performs acquire loads of the chain
+ *   pointers, so lookups are wait-free.
+ * - Writers never modify a node a reader might be looking at. ht_set builds a
+ *   new node (a copy with the new value, or a fresh node for a new key) and
+ *   publishes it with a single release store into the bucket or predecessor's
+ *   `next`. ht_remove unlinks a node the same way.
+ * - Unlinked nodes are retired, not freed: a reader that loaded the pointer
+ *   before the unlink may still be walking them.
+ *
+ * Reclamation (quiescent-state-based RCU):
+ * - Every reader thread registers once (rcu_register_thread) and periodically
+ *   calls rcu_quiescent_state() at a point where it holds no node pointers,
+ *   e.g. between requests. That call is one load of the global grace-period
+ *   counter and one release store into the thread's own slot.
+ * - Retiring a node advances the grace-period counter and tags the node with
+ *   the new value. Once every online reader has announced that value (or a
+ *   later one) no reader can still reference the node, and it is freed.
+ * - Writers reclaim opportunistically after each update; synchronize_rcu()
+ *   waits until every node retired so far has been freed.
+ * - A reader that will block for a long time (e.g. waiting for work) calls
+ *   rcu_thread_offline() so it does not hold up reclamation, and
+ *   rcu_thread_online() before its next lookup.
+ *
+ * The bucket array is sized at ht_init and does not grow.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RCU_OFFLINE 0
+
+// Define the Item structure
+typedef struct Item {
+    int key;
+    int value;
+    _Atomic(struct Item *) next;   // For handling collisions using chaining
+    uint64_t retired_at;           // Grace period tag once unlinked
+    struct Item *retired_next;     // Link in the retired list
+} Item;
+
+// Define the HashTable structure
+typedef struct HashTable {
+    _Atomic(Item *) *table;
+    size_t size;                   // Power of two
+    pthread_mutex_t write_lock;    // Serializes updaters only
+    Item *retired_head;            // Oldest first, guarded by write_lock
+    Item *retired_tail;
+} HashTable;
+
+// Per-reader announcement slot
+typedef struct RcuReader {
+    _Atomic uint64_t seen;         // Last grace period observed, or RCU_OFFLINE
+    struct RcuReader *next;
+} RcuReader;
+
+static _Atomic uint64_t rcu_gp = 1;
+static RcuReader *rcu_readers = NULL;
+static pthread_mutex_t rcu_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local RcuReader *rcu_self = NULL;
+
+// Register the calling thread as a reader; it starts online
+void rcu_register_thread(void) {
+    RcuReader *reader = (RcuReader *)malloc(sizeof(RcuReader));
+    atomic_init(&reader->seen, atomic_load(&rcu_gp));
+    pthread_mutex_lock(&rcu_registry_lock);
+    reader->next = rcu_readers;
+    rcu_readers = reader;
+    pthread_mutex_unlock(&rcu_registry_lock);
+    rcu_self = reader;
+}
+
+void rcu_unregister_thread(void) {
+    pthread_mutex_lock(&rcu_registry_lock);
+    for (RcuReader **link = &rcu_readers; *link != NULL; link = &(*link)->next) {
+        if (*link == rcu_self) {
+            *link = rcu_self->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&rcu_registry_lock);
+    free(rcu_self);
+    rcu_self = NULL;
+}
+
+// Announce that this reader holds no node pointers
+void rcu_quiescent_state(void) {
+    atomic_store_explicit(&rcu_self->seen, atomic_load_explicit(&rcu_gp, memory_order_acquire),
+                          memory_order_release);
+}
+
+void rcu_thread_offline(void) {
+    atomic_store_explicit(&rcu_self->seen, RCU_OFFLINE, memory_order_release);
+}
+
+void rcu_thread_online(void) {
+    rcu_quiescent_state();
+    // The store above must be visible before this thread loads any node pointer;
+    // otherwise a reclaimer could still read RCU_OFFLINE and free the node (pairs
+    // with the fence in rcu_oldest_seen)
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+// Oldest grace period some online reader may still be inside
+static uint64_t rcu_oldest_seen(void) {
+    // Order the grace period bump in retire before reading any reader's `seen`
+    atomic_thread_fence(memory_order_seq_cst);
+    uint64_t oldest = atomic_load(&rcu_gp);
+    pthread_mutex_lock(&rcu_registry_lock);
+    for (RcuReader *reader = rcu_readers; reader != NULL; reader = reader->next) {
+        uint64_t seen = atomic_load_explicit(&reader->seen, memory_order_acquire);
+        if (seen != RCU_OFFLINE && seen < oldest) {
+            oldest = seen;
+        }
+    }
+    pthread_mutex_unlock(&rcu_registry_lock);
+    return oldest;
+}
+
+// Hash function to compute index based on key
+size_t hash_function(const HashTable *ht, int key) {
+    uint32_t h = (uint32_t)key * 0x9e3779b1u;   // Fibonacci hashing
+    return (h ^ (h >> 16)) & (ht->size - 1);
+}
+
+// Initialize the hash table with at least `buckets` buckets
+void ht_init(HashTable *ht, size_t buckets) {
+    ht->size = 16;
+    while (ht->size < buckets) {
+        ht->size *= 2;
+    }
+    ht->table = (_Atomic(Item *) *)malloc(ht->size * sizeof(*ht->table));
+    for (size_t i = 0; i < ht->size; i++) {
+        atomic_init(&ht->table[i], NULL);
+    }
+    pthread_mutex_init(&ht->write_lock, NULL);
+    ht->retired_head = ht->retired_tail = NULL;
+}
+
+// Queue an unlinked node; it is freed after the next grace period. Caller holds write_lock.
+static void retire(HashTable *ht, Item *item) {
+    item->retired_at = atomic_fetch_add(&rcu_gp, 1) + 1;
+    item->retired_next = NULL;
+    if (ht->retired_tail) {
+        ht->retired_tail->retired_next = item;
+    } else {
+        ht->retired_head = item;
+    }
+    ht->retired_tail = item;
+}
+
+// Free every retired node whose grace period has passed. Caller holds write_lock.
+static void reclaim(HashTable *ht) {
+    if (ht->retired_head == NULL) {
+        return;
+    }
+    uint64_t oldest = rcu_oldest_seen();
+    while (ht->retired_head != NULL && ht->retired_head->retired_at <= oldest) {
+        Item *item = ht->retired_head;
+        ht->retired_head = item->retired_next;
+        free(item);
+    }
+    if (ht->retired_head == NULL) {
+        ht->retired_tail = NULL;
+    }
+}
+
+// Wait until every node retired so far has been freed
+void synchronize_rcu(HashTable *ht) {
+    pthread_mutex_lock(&ht->write_lock);
+    reclaim(ht);
+    while (ht->retired_head != NULL) {
+        pthread_mutex_unlock(&ht->write_lock);
+        sched_yield();
+        pthread_mutex_lock(&ht->write_lock);
+        reclaim(ht);
+    }
+    pthread_mutex_unlock(&ht->write_lock);
+}
+
+// Add or update an item in the hash table (updater side)
+void ht_set(HashTable *ht, int key, int value) {
+    Item *new_item = (Item *)malloc(sizeof(Item));
+    new_item->key = key;
+    new_item->value = value;
+
+    pthread_mutex_lock(&ht->write_lock);
+    _Atomic(Item *) *link = &ht->table[hash_function(ht, key)];
+    Item *current = atomic_load_explicit(link, memory_order_relaxed);
+
+    // Search for the key in the linked list
+    while (current != NULL && current->key != key) {
+        link = &current->next;
+        current = atomic_load_explicit(link, memory_order_relaxed);
+    }
+
+    if (current != NULL) {
+        // Replace the node with an updated copy; readers see the old or the new one
+        atomic_init(&new_item->next, atomic_load_explicit(&current->next, memory_order_relaxed));
+        atomic_store_explicit(link, new_item, memory_order_release);
+        retire(ht, current);
+    } else {
+        // Key not found, publish a new item at the head of the bucket
+        _Atomic(Item *) *head = &ht->table[hash_function(ht, key)];
+        atomic_init(&new_item->next, atomic_load_explicit(head, memory_order_relaxed));
+        atomic_store_explicit(head, new_item, memory_order_release);
+    }
+
+    reclaim(ht);
+    pthread_mutex_unlock(&ht->write_lock);
+}
+
+// Retrieve the value for a given key (reader side, lock-free).
+// Returns 1 and stores the value if found, 0 otherwise.
+int ht_get(HashTable *ht, int key, int *value) {
+    Item *current = atomic_load_explicit(&ht->table[hash_function(ht, key)], memory_order_acquire);
+
+    while (current != NULL) {
+        if (current->key == key) {
+            *value = current->value;
+            return 1;
+        }
+        current = atomic_load_explicit(&current->next, memory_order_acquire);
+    }
+    return 0;
+}
+
+// Remove an item with the given key (updater side). Returns 1 if it was present.
+int ht_remove(HashTable *ht, int key) {
+    pthread_mutex_lock(&ht->write_lock);
+    _Atomic(Item *) *link = &ht->table[hash_function(ht, key)];
+    Item *current = atomic_load_explicit(link, memory_order_relaxed);
+
+    while (current != NULL && current->key != key) {
+        link = &current->next;
+        current = atomic_load_explicit(link, memory_order_relaxed);
+    }
+
+    int found = current != NULL;
+    if (found) {
+        // Unlink; the node keeps its `next` so readers standing on it can move on
+        atomic_store_explicit(link, atomic_load_explicit(&current->next, memory_order_relaxed),
+                              memory_order_release);
+        retire(ht, current);
+    }
+
+    reclaim(ht);
+    pthread_mutex_unlock(&ht->write_lock);
+    return found;
+}
+
+// Free the table; no reader may be using it any more
+void ht_destroy(HashTable *ht) {
+    for (size_t i = 0; i < ht->size; i++) {
+        Item *current = atomic_load(&ht->table[i]);
+        while (current != NULL) {
+            Item *next = atomic_load(&current->next);
+            free(current);
+            current = next;
+        }
+    }
+    while (ht->retired_head != NULL) {
+        Item *item = ht->retired_head;
+        ht->retired_head = item->retired_next;
+        free(item);
+    }
+    free(ht->table);
+    pthread_mutex_destroy(&ht->write_lock);
+}
+
+// Example usage: one config updater thread, several request threads
+#define NUM_READERS 4
+#define NUM_KEYS 64
+
+static HashTable config;
+static atomic_int stop = 0;
+
+void *request_thread(void *arg) {
+    long lookups = 0, hits = 0;
+    (void)arg;
+    rcu_register_thread();
+    while (!atomic_load(&stop)) {
+        for (int key = 0; key < NUM_KEYS; key++) {
+            int value;
+            if (ht_get(&config, key, &value)) {
+                if (value % 1000 != key) {
+                    printf("Inconsistent value %d for key %d\n", value, key);
+                }
+                hits++;
+            }
+            lookups++;
+        }
+        rcu_quiescent_state();  // Between "requests": no node pointers held
+    }
+    rcu_unregister_thread();
+    printf("Reader: %ld lookups, %ld hits\n", lookups, hits);
+    return NULL;
+}
+
+void *updater_thread(void *arg) {
+    (void)arg;
+    for (int round = 1; round <= 2000; round++) {
+        for (int key = 0; key < NUM_KEYS; key++) {
+            if ((key + round) % 7 == 0) {
+                ht_remove(&config, key);
+            } else {
+                ht_set(&config, key, round * 1000 + key);
+            }
+        }
+    }
+    atomic_store(&stop, 1);
+    return NULL;
+}
+
+int main() {
+    pthread_t readers[NUM_READERS], updater;
+    ht_init(&config, NUM_KEYS);
+
+    for (int i = 0; i < NUM_READERS; i++) {
+        pthread_create(&readers[i], NULL, request_thread, NULL);
+    }
+    pthread_create(&updater, NULL, updater_thread, NULL);
+
+    pthread_join(updater, NULL);
+    for (int i = 0; i < NUM_READERS; i++) {
+        pthread_join(readers[i], NULL);
+    }
+
+    synchronize_rcu(&config);
+    int value;
+    printf("Value for key 1: %s\n", ht_get(&config, 1, &value) ? "present" : "missing");
+    ht_destroy(&config);
+    return 0;
+}
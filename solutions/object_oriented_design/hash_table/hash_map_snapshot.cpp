@@ -0,0 +1,301 @@
+/*
+ * Explanation:
+ *
+ * MappedHashTable Class Template `MappedHashTable<K, V, Hash>`:
+ * - Persists a `HashTable` to a flat file and serves lookups straight from an `mmap` of
+ *   that file, so a restart does not rebuild the table through millions of `set` calls.
+ * - `serialize` Method: Writes the table as an open-addressing image: a header, one
+ *   control byte per slot, then an array of `{key, value}` slots. All positions in the
+ *   file are offsets from its start, so the image is position independent. The file is
+ *   written through a shared mapping of a temporary file, then renamed into place, so a
+ *   crash never leaves a half-written snapshot under the final name.
+ * - Constructor: Maps the file and validates it. The header carries a magic number, a
+ *   format version, the key/value sizes and a checksum of its own fields, which are
+ *   always checked (a few dozen bytes). The slot data has its own checksum, verified
+ *   unless `verify_data` is false; it is computed eight bytes at a time, so even a large
+ *   image validates at memory speed.
+ * - `find`/`contains`/`get` Methods: Hash the key and probe the mapped slots directly.
+ *   There is no deserialization step; pages are faulted in on first use.
+ * - `Mode::ReadOnly` maps the file `PROT_READ`/`MAP_SHARED`. `Mode::CopyOnWrite` maps it
+ *   `MAP_PRIVATE`, so `set`/`erase` can modify the in-memory table while the file on disk
+ *   stays unchanged; only the pages that are written are copied.
+ * - Errors (unreadable file, bad magic, version, sizes, layout or checksum, writing in read-only
+ *   mode, no free slot) are reported with `std::runtime_error`.
+ *
+ * Implementation Details:
+ * - `K` and `V` must be trivially copyable, and `Hash` must give the same result in the
+ *   process that reads the file as in the one that wrote it.
+ * - Slots are sized for a load factor of at most 7/10 and probed linearly; the slot array
+ *   starts on a 64-byte boundary.
+ * - Byte order is not converted; a file written on a machine of the other endianness is
+ *   rejected by the magic number check.
+ * - Uses POSIX `open`/`ftruncate`/`mmap`/`rename`.
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <stdexcept> // for std::runtime_error
+#include <string>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash_map.cpp"
+
+struct SnapshotHeader {
+    static constexpr uint64_t MAGIC = 0x50414e5348534854ULL;   // "THSHSNAP" read little-endian
+    static constexpr uint32_t VERSION = 1;
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t key_size;
+    uint32_t value_size;
+    uint32_t slot_size;
+    uint32_t reserved;
+    uint64_t capacity;          // Slots, a power of two
+    uint64_t count;             // Full slots
+    uint64_t ctrl_offset;
+    uint64_t slots_offset;
+    uint64_t file_size;
+    uint64_t data_checksum;     // Over [ctrl_offset, file_size)
+    uint64_t header_checksum;   // Over every field above
+};
+
+// Word-at-a-time checksum; the tail shorter than eight bytes is zero padded.
+inline uint64_t snapshot_checksum(const void* data, size_t len) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t sum = 0x9e3779b97f4a7c15ULL ^ len;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, p + i, 8);
+        sum = (sum ^ hash_mix(word)) * 0x100000001b3ULL;
+    }
+    if (i < len) {
+        uint64_t word = 0;
+        std::memcpy(&word, p + i, len - i);
+        sum = (sum ^ hash_mix(word)) * 0x100000001b3ULL;
+    }
+    return hash_mix(sum);
+}
+
+template <typename K = int, typename V = int, typename Hash = std::hash<K>>
+class MappedHashTable {
+public:
+    enum class Mode { ReadOnly, CopyOnWrite };
+
+private:
+    static_assert(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value,
+                  "snapshot slots are copied byte for byte");
+
+    enum : uint8_t { EMPTY = 0, FULL = 1, DELETED = 2 };
+
+    struct Slot {
+        K key;
+        V value;
+    };
+
+    void* base;
+    size_t length;
+    Mode mode;
+    SnapshotHeader* header;
+    uint8_t* ctrl;
+    Slot* slots;
+    Hash hasher;
+
+    static uint64_t header_checksum(const SnapshotHeader& h) {
+        return snapshot_checksum(&h, offsetof(SnapshotHeader, header_checksum));
+    }
+
+    static size_t align_up(size_t n, size_t a) { return (n + a - 1) & ~(a - 1); }
+
+    uint64_t hash_function(const K& key) const {
+        return hash_mix(static_cast<uint64_t>(hasher(key)));
+    }
+
+    // Slot holding `key`, or `capacity` if it is absent.
+    size_t probe(const K& key) const {
+        size_t mask = header->capacity - 1;
+        for (size_t i = hash_function(key) & mask, n = 0; n < header->capacity; i = (i + 1) & mask, n++) {
+            if (ctrl[i] == EMPTY) break;
+            if (ctrl[i] == FULL && slots[i].key == key) return i;
+        }
+        return header->capacity;
+    }
+
+    void fail(const std::string& what) {
+        if (base) munmap(base, length);
+        base = nullptr;
+        throw std::runtime_error(what);
+    }
+
+public:
+    // Writes `table` to `path` as a snapshot that the constructor can map.
+    template <typename Eq, typename Alloc>
+    static void serialize(const HashTable<K, V, Hash, Eq, Alloc>& table, const std::string& path,
+                          const Hash& h = Hash()) {
+        size_t capacity = 16;
+        while (capacity * 7 / 10 < table.items()) capacity *= 2;
+
+        SnapshotHeader header{};
+        header.magic = SnapshotHeader::MAGIC;
+        header.version = SnapshotHeader::VERSION;
+        header.header_size = sizeof(SnapshotHeader);
+        header.key_size = sizeof(K);
+        header.value_size = sizeof(V);
+        header.slot_size = sizeof(Slot);
+        header.capacity = capacity;
+        header.count = table.items();
+        header.ctrl_offset = sizeof(SnapshotHeader);
+        header.slots_offset = align_up(header.ctrl_offset + capacity, 64);
+        header.file_size = header.slots_offset + capacity * sizeof(Slot);
+
+        std::string tmp = path + ".tmp";
+        int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) throw std::runtime_error("Cannot create snapshot " + tmp);
+        if (ftruncate(fd, static_cast<off_t>(header.file_size)) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot size snapshot " + tmp);
+        }
+        void* map = mmap(nullptr, header.file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) throw std::runtime_error("Cannot map snapshot " + tmp);
+
+        // ftruncate zero-fills, so every control byte already reads EMPTY.
+        char* bytes = static_cast<char*>(map);
+        uint8_t* ctrl = reinterpret_cast<uint8_t*>(bytes + header.ctrl_offset);
+        Slot* slots = reinterpret_cast<Slot*>(bytes + header.slots_offset);
+        table.for_each([&](const K& key, const V& value) {
+            size_t i = hash_mix(static_cast<uint64_t>(h(key))) & (capacity - 1);
+            while (ctrl[i] != EMPTY) i = (i + 1) & (capacity - 1);
+            ctrl[i] = FULL;
+            std::memcpy(&slots[i].key, &key, sizeof(K));
+            std::memcpy(&slots[i].value, &value, sizeof(V));
+        });
+
+        header.data_checksum = snapshot_checksum(bytes + header.ctrl_offset, header.file_size - header.ctrl_offset);
+        header.header_checksum = header_checksum(header);
+        std::memcpy(bytes, &header, sizeof(header));
+
+        bool synced = msync(map, header.file_size, MS_SYNC) == 0;
+        munmap(map, header.file_size);
+        if (!synced || std::rename(tmp.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("Cannot write snapshot " + path);
+        }
+    }
+
+    MappedHashTable(const std::string& path, Mode m = Mode::ReadOnly, bool verify_data = true,
+                    const Hash& h = Hash())
+        : base(nullptr), length(0), mode(m), header(nullptr), ctrl(nullptr), slots(nullptr), hasher(h) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open snapshot " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+            ::close(fd);
+            throw std::runtime_error("Snapshot too small: " + path);
+        }
+        length = static_cast<size_t>(st.st_size);
+        int prot = mode == Mode::ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+        int flags = mode == Mode::ReadOnly ? MAP_SHARED : MAP_PRIVATE;
+        base = mmap(nullptr, length, prot, flags, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            base = nullptr;
+            throw std::runtime_error("Cannot map snapshot " + path);
+        }
+
+        // The layout is checked before anything is read through the offsets, so
+        // that a header with a matching checksum cannot point outside the mapping.
+        header = static_cast<SnapshotHeader*>(base);
+        if (header->magic != SnapshotHeader::MAGIC) fail("Not a hash table snapshot: " + path);
+        if (header->version != SnapshotHeader::VERSION) fail("Unsupported snapshot version: " + path);
+        if (header->header_size != sizeof(SnapshotHeader) || header->key_size != sizeof(K) ||
+            header->value_size != sizeof(V) || header->slot_size != sizeof(Slot)) {
+            fail("Snapshot was written for different key/value types: " + path);
+        }
+        uint64_t capacity = header->capacity;
+        uint64_t ctrl_offset = header->ctrl_offset;
+        uint64_t slots_offset = header->slots_offset;
+        if (header->file_size != length || capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+            ctrl_offset != sizeof(SnapshotHeader) || slots_offset < ctrl_offset || slots_offset > length ||
+            slots_offset - ctrl_offset < capacity || slots_offset % alignof(Slot) != 0 ||
+            capacity > (length - slots_offset) / sizeof(Slot) ||
+            slots_offset + capacity * sizeof(Slot) != length) {
+            fail("Truncated snapshot: " + path);
+        }
+        if (header->header_checksum != header_checksum(*header)) fail("Corrupt snapshot header: " + path);
+
+        char* bytes = static_cast<char*>(base);
+        if (verify_data &&
+            header->data_checksum != snapshot_checksum(bytes + header->ctrl_offset, length - header->ctrl_offset)) {
+            fail("Corrupt snapshot data: " + path);
+        }
+        ctrl = reinterpret_cast<uint8_t*>(bytes + header->ctrl_offset);
+        slots = reinterpret_cast<Slot*>(bytes + header->slots_offset);
+    }
+
+    MappedHashTable(const MappedHashTable&) = delete;
+    MappedHashTable& operator=(const MappedHashTable&) = delete;
+
+    ~MappedHashTable() {
+        if (base) munmap(base, length);
+    }
+
+    const V* find(const K& key) const {
+        size_t i = probe(key);
+        return i == header->capacity ? nullptr : &slots[i].value;
+    }
+
+    bool contains(const K& key) const {
+        return find(key) != nullptr;
+    }
+
+    V get(const K& key) const {
+        if (const V* value = find(key)) {
+            return *value;
+        }
+        throw std::runtime_error("Key not found");
+    }
+
+    // Copy-on-write mode only. Changes stay in this process's private pages.
+    void set(const K& key, const V& value) {
+        if (mode == Mode::ReadOnly) {
+            throw std::runtime_error("Snapshot is mapped read-only");
+        }
+        size_t i = probe(key);
+        if (i != header->capacity) {
+            slots[i].value = value;
+            return;
+        }
+        size_t mask = header->capacity - 1;
+        for (size_t j = hash_function(key) & mask, n = 0; n < header->capacity; j = (j + 1) & mask, n++) {
+            if (ctrl[j] != FULL) {
+                ctrl[j] = FULL;
+                slots[j].key = key;
+                slots[j].value = value;
+                header->count++;
+                return;
+            }
+        }
+        throw std::runtime_error("Snapshot is full");
+    }
+
+    bool erase(const K& key) {
+        if (mode == Mode::ReadOnly) {
+            throw std::runtime_error("Snapshot is mapped read-only");
+        }
+        size_t i = probe(key);
+        if (i == header->capacity) return false;
+        ctrl[i] = DELETED;
+        header->count--;
+        return true;
+    }
+
+    size_t items() const { return header->count; }
+};
@@ -0,0 +1,457 @@
+/*
+ * C++ version of the read-through query cache in query_cache_snippets.py.
+ *
+ * Explanation:
+ *
+ * QueryApi::process_query follows the Python version: parse the query, return the cached
+ * results if there are any, otherwise ask the search backend and cache its answer. Two
+ * things are added for hot queries:
+ *
+ * - Single-flight: on a miss, the first request for a query becomes the leader and calls
+ *   the backend; every request for the same query that arrives meanwhile waits on the
+ *   leader's `std::shared_future` instead of calling the backend too. A burst of N misses
+ *   on one query costs one backend call, not N (no thundering herd). If the backend
+ *   throws, the leader and all waiters get the exception and nothing is cached.
+ * - Stale-while-revalidate: an entry is fresh for `fresh_for`, then stale for another
+ *   `stale_for`. A stale hit returns the cached results at once and queues one refresh
+ *   for that query on the background refresher thread; later requests keep getting the
+ *   stale results until the refresh lands. A failed refresh leaves the stale entry in
+ *   place. Past `fresh_for + stale_for` the entry counts as a miss.
+ * - Refreshes go through the same in-flight table as misses, so a miss that arrives
+ *   while a refresh of its query is running waits for that refresh.
+ *
+ * Components:
+ * - `SearchBackend` is the pluggable backend (`reverse_index_cluster` in the Python
+ *   version). `LocalIndexBackend` is an in-process stand-in with an inverted index, an
+ *   optional artificial latency and a call counter, for tests and the example below.
+ * - `Cache` is the LRU from the Python version (list + hash map, `MAX_SIZE` entries),
+ *   behind one mutex. It stores `shared_ptr<const Results>`, so a hit copies a pointer,
+ *   not the result list, and readers never see an entry change under them.
+ *
+ * Build and run:
+ *   g++ -O2 -std=c++17 -pthread query_cache.cpp -o query_cache
+ *   ./query_cache
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+using Results = std::vector<std::string>;
+using ResultsPtr = std::shared_ptr<const Results>;
+
+// Interface of the search cluster behind the cache
+class SearchBackend {
+public:
+    virtual ~SearchBackend() = default;
+    // Results for a parsed query; may throw
+    virtual Results process_search(const std::string& query) = 0;
+};
+
+// In-process stand-in for the reverse index cluster: documents are indexed by term and a
+// query returns the documents containing all of its terms.
+class LocalIndexBackend : public SearchBackend {
+private:
+    std::unordered_map<std::string, std::vector<std::string>> index;   // term -> documents
+    std::chrono::microseconds latency;
+    std::atomic<uint64_t> calls{0};
+    mutable std::mutex lock;
+
+public:
+    explicit LocalIndexBackend(std::chrono::microseconds latency = std::chrono::microseconds(0))
+        : latency(latency) {}
+
+    void add_document(const std::string& document) {
+        std::lock_guard<std::mutex> guard(lock);
+        std::istringstream terms(document);
+        std::string term;
+        while (terms >> term) {
+            std::transform(term.begin(), term.end(), term.begin(), ::tolower);
+            std::vector<std::string>& documents = index[term];
+            if (documents.empty() || documents.back() != document) documents.push_back(document);
+        }
+    }
+
+    Results process_search(const std::string& query) override {
+        calls.fetch_add(1, std::memory_order_relaxed);
+        if (latency.count() > 0) std::this_thread::sleep_for(latency);
+
+        std::lock_guard<std::mutex> guard(lock);
+        std::istringstream terms(query);
+        std::string term;
+        Results results;
+        bool first = true;
+        while (terms >> term) {
+            auto it = index.find(term);
+            if (it == index.end()) return Results();
+            if (first) {
+                results = it->second;
+                first = false;
+                continue;
+            }
+            Results kept;
+            for (const std::string& document : results) {
+                if (std::find(it->second.begin(), it->second.end(), document) != it->second.end()) {
+                    kept.push_back(document);
+                }
+            }
+            results.swap(kept);
+        }
+        return results;
+    }
+
+    uint64_t call_count() const { return calls.load(std::memory_order_relaxed); }
+};
+
+// LRU cache of query -> results, as in the Python Cache class, with the time each entry
+// was stored
+class Cache {
+private:
+    struct Node {
+        std::string query;
+        ResultsPtr results;
+        Clock::time_point stored_at;
+    };
+
+    size_t max_size;
+    std::list<Node> linked_list;   // Most recently used at the front
+    std::unordered_map<std::string, std::list<Node>::iterator> lookup;
+    std::mutex lock;
+
+public:
+    explicit Cache(size_t max_size) : max_size(max_size) {}
+
+    // Results and store time for a query; results are null on a miss
+    std::pair<ResultsPtr, Clock::time_point> get(const std::string& query) {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = lookup.find(query);
+        if (it == lookup.end()) return {nullptr, Clock::time_point()};
+        linked_list.splice(linked_list.begin(), linked_list, it->second);   // move_to_front
+        return {it->second->results, it->second->stored_at};
+    }
+
+    void set(const std::string& query, ResultsPtr results) {
+        if (max_size == 0) return;
+        std::lock_guard<std::mutex> guard(lock);
+        Clock::time_point now = Clock::now();
+        auto it = lookup.find(query);
+        if (it != lookup.end()) {
+            it->second->results = std::move(results);
+            it->second->stored_at = now;
+            linked_list.splice(linked_list.begin(), linked_list, it->second);
+            return;
+        }
+        if (lookup.size() == max_size) {   // remove_from_tail
+            lookup.erase(linked_list.back().query);
+            linked_list.pop_back();
+        }
+        linked_list.push_front(Node{query, std::move(results), now});
+        lookup[query] = linked_list.begin();
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> guard(lock);
+        return lookup.size();
+    }
+};
+
+struct QueryApiStats {
+    uint64_t hits = 0;          // Fresh cache hits
+    uint64_t stale_hits = 0;    // Served stale while a refresh was queued or running
+    uint64_t misses = 0;        // Requests that called the backend themselves
+    uint64_t coalesced = 0;     // Requests that waited for another request's backend call
+    uint64_t refreshes = 0;     // Background refreshes run
+    uint64_t refresh_errors = 0;
+};
+
+class QueryApi {
+private:
+    Cache& memory_cache;
+    SearchBackend& reverse_index_cluster;
+    Clock::duration fresh_for;
+    Clock::duration stale_for;
+
+    // Backend calls in progress, by parsed query
+    std::mutex flights_lock;
+    std::unordered_map<std::string, std::shared_future<ResultsPtr>> in_flight;
+
+    // Background refresher
+    std::mutex refresh_lock;
+    std::condition_variable refresh_ready;
+    std::deque<std::string> refresh_queue;
+    std::unordered_set<std::string> refresh_queued;   // Queries in refresh_queue
+    bool stopping = false;
+    std::thread refresher;
+
+    std::atomic<uint64_t> hits{0}, stale_hits{0}, misses{0}, coalesced{0};
+    std::atomic<uint64_t> refreshes{0}, refresh_errors{0};
+
+    // Call the backend for `query` unless a call is already in flight, in which case wait
+    // for that one. Stores the result in the cache. `led` tells whether this call did it.
+    ResultsPtr fetch(const std::string& query, bool* led) {
+        std::promise<ResultsPtr> promise;
+        std::shared_future<ResultsPtr> flight;
+        {
+            std::lock_guard<std::mutex> guard(flights_lock);
+            auto it = in_flight.find(query);
+            if (it != in_flight.end()) {
+                flight = it->second;
+            } else {
+                in_flight.emplace(query, promise.get_future().share());
+            }
+        }
+        if (flight.valid()) {
+            *led = false;
+            return flight.get();   // Rethrows the leader's exception
+        }
+
+        *led = true;
+        try {
+            ResultsPtr results = std::make_shared<const Results>(reverse_index_cluster.process_search(query));
+            memory_cache.set(query, results);
+            finish(query);
+            promise.set_value(results);
+            return results;
+        } catch (...) {
+            finish(query);
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    // Close a flight. Done before the promise is fulfilled, so a request that finds no
+    // flight afterwards also finds the cache already updated.
+    void finish(const std::string& query) {
+        std::lock_guard<std::mutex> guard(flights_lock);
+        in_flight.erase(query);
+    }
+
+    void queue_refresh(const std::string& query) {
+        {
+            std::lock_guard<std::mutex> guard(refresh_lock);
+            if (stopping || !refresh_queued.insert(query).second) return;
+            refresh_queue.push_back(query);
+        }
+        refresh_ready.notify_one();
+    }
+
+    void refresh_loop() {
+        std::unique_lock<std::mutex> guard(refresh_lock);
+        for (;;) {
+            refresh_ready.wait(guard, [this] { return stopping || !refresh_queue.empty(); });
+            if (stopping) return;
+            std::string query = std::move(refresh_queue.front());
+            refresh_queue.pop_front();
+            guard.unlock();
+
+            bool led;
+            try {
+                fetch(query, &led);
+                if (led) refreshes.fetch_add(1, std::memory_order_relaxed);
+            } catch (...) {
+                refresh_errors.fetch_add(1, std::memory_order_relaxed);   // Keep serving stale
+            }
+
+            guard.lock();
+            refresh_queued.erase(query);
+        }
+    }
+
+public:
+    QueryApi(Cache& memory_cache, SearchBackend& reverse_index_cluster,
+             Clock::duration fresh_for, Clock::duration stale_for = Clock::duration::zero())
+        : memory_cache(memory_cache),
+          reverse_index_cluster(reverse_index_cluster),
+          fresh_for(fresh_for),
+          stale_for(stale_for),
+          refresher(&QueryApi::refresh_loop, this) {}
+
+    // Waits for a running refresh; queued ones are dropped
+    ~QueryApi() {
+        {
+            std::lock_guard<std::mutex> guard(refresh_lock);
+            stopping = true;
+        }
+        refresh_ready.notify_one();
+        refresher.join();
+    }
+
+    QueryApi(const QueryApi&) = delete;
+    QueryApi& operator=(const QueryApi&) = delete;
+
+    // Remove markup, normalize capitalization and whitespace, so that equivalent queries
+    // share a cache entry
+    static std::string parse_query(const std::string& query) {
+        std::string parsed;
+        bool space = false;
+        bool in_tag = false;
+        for (unsigned char c : query) {
+            if (c == '<' || c == '>') {
+                in_tag = c == '<';
+                space = true;
+            } else if (in_tag) {
+                continue;
+            } else if (std::isalnum(c)) {
+                if (space && !parsed.empty()) parsed += ' ';
+                parsed += static_cast<char>(std::tolower(c));
+                space = false;
+            } else {
+                space = true;
+            }
+        }
+        return parsed;
+    }
+
+    // Results for a query: fresh from the cache, stale from the cache while a refresh
+    // runs in the background, or from the backend (one call per query at a time).
+    // Throws whatever the backend throws on a miss.
+    ResultsPtr process_query(const std::string& raw_query) {
+        std::string query = parse_query(raw_query);
+        auto cached = memory_cache.get(query);
+        if (cached.first) {
+            Clock::duration age = Clock::now() - cached.second;
+            if (age < fresh_for) {
+                hits.fetch_add(1, std::memory_order_relaxed);
+                return cached.first;
+            }
+            if (age < fresh_for + stale_for) {
+                stale_hits.fetch_add(1, std::memory_order_relaxed);
+                queue_refresh(query);
+                return cached.first;
+            }
+        }
+
+        bool led;
+        ResultsPtr results = fetch(query, &led);
+        (led ? misses : coalesced).fetch_add(1, std::memory_order_relaxed);
+        return results;
+    }
+
+    QueryApiStats stats() const {
+        QueryApiStats s;
+        s.hits = hits.load(std::memory_order_relaxed);
+        s.stale_hits = stale_hits.load(std::memory_order_relaxed);
+        s.misses = misses.load(std::memory_order_relaxed);
+        s.coalesced = coalesced.load(std::memory_order_relaxed);
+        s.refreshes = refreshes.load(std::memory_order_relaxed);
+        s.refresh_errors = refresh_errors.load(std::memory_order_relaxed);
+        return s;
+    }
+};
+
+// Example usage with the in-process backend
+
+// Backend whose answers carry a version number, so a refresh is visible, and which can be
+// made to fail
+class VersionedBackend : public SearchBackend {
+public:
+    std::atomic<int> version{1};
+    std::atomic<bool> failing{false};
+    std::atomic<uint64_t> calls{0};
+
+    Results process_search(const std::string& query) override {
+        calls.fetch_add(1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (failing.load()) throw std::runtime_error("backend unavailable");
+        return Results{query + " v" + std::to_string(version.load())};
+    }
+};
+
+static void print_stats(const QueryApi& api) {
+    QueryApiStats s = api.stats();
+    printf("  hits %llu, stale hits %llu, misses %llu, coalesced %llu, refreshes %llu, refresh errors %llu\n",
+           (unsigned long long)s.hits, (unsigned long long)s.stale_hits, (unsigned long long)s.misses,
+           (unsigned long long)s.coalesced, (unsigned long long)s.refreshes,
+           (unsigned long long)s.refresh_errors);
+}
+
+// Run `threads` concurrent requests for one query; returns how many threw
+static int burst(QueryApi& api, const std::string& query, int threads) {
+    std::atomic<int> errors{0};
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back([&] {
+            try {
+                api.process_query(query);
+            } catch (const std::exception&) {
+                errors.fetch_add(1);
+            }
+        });
+    }
+    for (std::thread& t : workers) t.join();
+    return errors.load();
+}
+
+int main() {
+    using std::chrono::milliseconds;
+
+    // Inverted index stand-in
+    LocalIndexBackend index(std::chrono::microseconds(5000));
+    index.add_document("hello world");
+    index.add_document("hello there");
+    index.add_document("goodbye world");
+    Cache index_cache(100);
+    {
+        QueryApi api(index_cache, index, std::chrono::seconds(60));
+        for (const char* query : {"Hello", "<b>hello</b> WORLD", "hello   world", "world"}) {
+            ResultsPtr results = api.process_query(query);
+            printf("%-22s ->", query);
+            for (const std::string& document : *results) printf(" [%s]", document.c_str());
+            printf("\n");
+        }
+        printf("backend calls for 4 queries (2 equivalent): %llu\n",
+               (unsigned long long)index.call_count());
+    }
+
+    VersionedBackend backend;
+    Cache cache(100);
+    QueryApi api(cache, backend, milliseconds(100), milliseconds(1000));
+
+    printf("\n64 concurrent misses on one query\n");
+    burst(api, "hot query", 64);
+    printf("  backend calls: %llu\n", (unsigned long long)backend.calls.load());
+    print_stats(api);
+
+    printf("\nStale-while-revalidate\n");
+    std::this_thread::sleep_for(milliseconds(150));   // Now stale
+    backend.version = 2;
+    Clock::time_point start = Clock::now();
+    ResultsPtr stale = api.process_query("hot query");
+    double served_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    printf("  stale read: %s in %.0f us\n", (*stale)[0].c_str(), served_us);
+    burst(api, "hot query", 16);                       // Still stale, one refresh queued
+    std::this_thread::sleep_for(milliseconds(50));     // Let the refresh land
+    printf("  after refresh: %s, backend calls: %llu\n", (*api.process_query("hot query"))[0].c_str(),
+           (unsigned long long)backend.calls.load());
+    print_stats(api);
+
+    printf("\nBackend failures\n");
+    backend.failing = true;
+    uint64_t before = backend.calls.load();
+    int errors = burst(api, "cold query", 16);
+    printf("  16 concurrent misses: %d errors, %llu backend call\n", errors,
+           (unsigned long long)(backend.calls.load() - before));
+    std::this_thread::sleep_for(milliseconds(150));   // hot query stale again
+    printf("  stale read while the refresh fails: %s\n", (*api.process_query("hot query"))[0].c_str());
+    std::this_thread::sleep_for(milliseconds(50));
+    print_stats(api);
+    printf("  backend calls: %llu\n", (unsigned long long)backend.calls.load());
+    return 0;
+}
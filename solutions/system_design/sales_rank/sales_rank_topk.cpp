@@ -0,0 +1,320 @@
+/*
+ * Per-category top-k sales ranking without a full sort.
+ *
+ * Explanation:
+ * - sales_rank_mapreduce.py ranks products with a distributed sort on (category, quantity)
+ *   in `mapper_sort`. The page only shows the top 100 per category, so sorting every row is
+ *   wasted work: this driver keeps one bounded heap of k entries per category instead.
+ * - `TopK` is a C++ version of the same algorithm as the bounded top-k mode of
+ *   C_LLD/memory_management/binary_heap/binary_heap.c (`offerTopK`), which only holds int
+ *   keys. It is generic over the entry type, so it holds (quantity, product) entries: a
+ *   min-heap of capacity k whose root is the weakest entry kept. A candidate that
+ *   does not beat the root is rejected with that one comparison, which is what happens to
+ *   almost every row once the heap is full; one that does replaces the root and sifts down.
+ *   Rejected rows never copy their product id. Cost is O(n + accepted * log k) instead
+ *   of O(n log n), and memory is O(categories * k) instead of O(n).
+ * - Ties on quantity are broken by product id, so the output is deterministic and matches
+ *   a sort.
+ *
+ * Input (the output of the first MapReduce step, one row per category and product):
+ *   category <TAB> product_id <TAB> quantity
+ *
+ * Output, categories in name order, best product first:
+ *   category <TAB> rank <TAB> product_id <TAB> quantity
+ *
+ * Build and run:
+ *   g++ -O2 -std=c++17 sales_rank_topk.cpp -o sales_rank_topk
+ *   ./sales_rank_topk [-k 100] [file]          (reads stdin without a file)
+ *   ./sales_rank_topk --bench 100000000 [-k 100] [-c 1000]
+ *
+ * --bench generates rows in memory and times the heap against `std::sort` of all rows by
+ * (category, quantity), the single-machine equivalent of `mapper_sort`, and checks that
+ * both produce the same rankings.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Bounded top-k heap: keeps the k best entries offered to it. `Better(a, b)` is true if
+// `a` ranks above `b`; the root is the entry that every other kept entry ranks above.
+template <typename T, typename Better>
+class TopK {
+private:
+    std::vector<T> heap;
+    size_t k;
+    Better better;
+
+    // Sift `value` down from the hole at `i`, keeping the weakest entry at the root
+    void sift_down(size_t i, T value) {
+        size_t n = heap.size();
+        for (;;) {
+            size_t child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && better(heap[child], heap[child + 1])) child++;
+            if (!better(value, heap[child])) break;
+            heap[i] = std::move(heap[child]);
+            i = child;
+        }
+        heap[i] = std::move(value);
+    }
+
+    void sift_up(size_t i, T value) {
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!better(heap[parent], value)) break;
+            heap[i] = std::move(heap[parent]);
+            i = parent;
+        }
+        heap[i] = std::move(value);
+    }
+
+public:
+    explicit TopK(size_t k, Better better = Better()) : k(k), better(better) { heap.reserve(k); }
+
+    // The weakest entry kept once k entries are held, else null. Anything that does not
+    // beat it would be rejected by `offer`.
+    const T* weakest() const { return heap.size() == k && k > 0 ? &heap[0] : nullptr; }
+
+    // Offer an entry; it is kept if it ranks among the k best so far
+    void offer(T value) {
+        if (heap.size() < k) {
+            heap.push_back(value);
+            sift_up(heap.size() - 1, std::move(value));
+        } else if (k > 0 && better(value, heap[0])) {
+            sift_down(0, std::move(value));
+        }
+    }
+
+    // The kept entries, best first. Leaves the heap empty.
+    std::vector<T> take_sorted() {
+        std::vector<T> result(heap.size());
+        for (size_t i = result.size(); i-- > 0;) {
+            result[i] = std::move(heap[0]);
+            T last = std::move(heap.back());
+            heap.pop_back();
+            if (!heap.empty()) sift_down(0, std::move(last));
+        }
+        return result;
+    }
+};
+
+// Streaming mode: rows from a file
+
+struct Sale {
+    uint64_t quantity;
+    std::string product_id;
+};
+
+struct SaleBetter {
+    bool operator()(const Sale& a, const Sale& b) const {
+        return a.quantity != b.quantity ? a.quantity > b.quantity : a.product_id < b.product_id;
+    }
+};
+
+struct CategoryRanking {
+    TopK<Sale, SaleBetter> top;
+    explicit CategoryRanking(size_t k) : top(k) {}
+};
+
+class TopKRanker {
+private:
+    size_t k;
+    std::unordered_map<std::string, CategoryRanking> categories;
+    // Cache for runs of rows of the same category, common in grouped MapReduce output
+    std::string last_category;
+    CategoryRanking* last = nullptr;
+
+public:
+    explicit TopKRanker(size_t k) : k(k) {}
+
+    void add(const char* category, size_t category_length, const char* product, size_t product_length,
+             uint64_t quantity) {
+        if (!last || last_category.size() != category_length ||
+            memcmp(last_category.data(), category, category_length) != 0) {
+            last_category.assign(category, category_length);
+            last = &categories.try_emplace(last_category, k).first->second;
+        }
+        // Almost every row stops here, after one comparison and without copying its id
+        const Sale* weakest = last->top.weakest();
+        if (weakest && quantity < weakest->quantity) return;
+        last->top.offer(Sale{quantity, std::string(product, product_length)});
+    }
+
+    void print() {
+        std::vector<std::pair<std::string, CategoryRanking*>> sorted;
+        for (auto& entry : categories) sorted.emplace_back(entry.first, &entry.second);
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (auto& entry : sorted) {
+            std::vector<Sale> ranked = entry.second->top.take_sorted();
+            for (size_t i = 0; i < ranked.size(); i++) {
+                printf("%s\t%zu\t%s\t%llu\n", entry.first.c_str(), i + 1, ranked[i].product_id.c_str(),
+                       (unsigned long long)ranked[i].quantity);
+            }
+        }
+    }
+};
+
+// Parse tab-separated rows from `in` in large blocks. Returns false on a malformed row.
+static bool rank_stream(FILE* in, TopKRanker& ranker) {
+    std::vector<char> buffer(1 << 20);
+    size_t kept = 0;      // Bytes of an unfinished line carried over to the next block
+    size_t line_number = 0;
+    for (;;) {
+        size_t got = fread(buffer.data() + kept, 1, buffer.size() - kept, in);
+        size_t end = kept + got;
+        bool eof = got == 0;
+        if (eof && kept == 0) return true;
+        if (eof) buffer[end++] = '\n';   // Last line without a newline
+
+        size_t start = 0;
+        for (;;) {
+            char* line = buffer.data() + start;
+            char* newline = static_cast<char*>(memchr(line, '\n', end - start));
+            if (!newline) break;
+            line_number++;
+            char* stop = newline > line && newline[-1] == '\r' ? newline - 1 : newline;
+            if (stop > line) {
+                char* tab1 = static_cast<char*>(memchr(line, '\t', stop - line));
+                char* tab2 = tab1 ? static_cast<char*>(memchr(tab1 + 1, '\t', stop - tab1 - 1)) : nullptr;
+                uint64_t quantity = 0;
+                char* digit = tab2 ? tab2 + 1 : stop;
+                if (!tab2 || digit == stop) {
+                    fprintf(stderr, "line %zu: expected category, product_id and quantity\n", line_number);
+                    return false;
+                }
+                for (; digit < stop; digit++) {
+                    if (*digit < '0' || *digit > '9') {
+                        fprintf(stderr, "line %zu: bad quantity\n", line_number);
+                        return false;
+                    }
+                    quantity = quantity * 10 + (uint64_t)(*digit - '0');
+                }
+                ranker.add(line, tab1 - line, tab1 + 1, tab2 - tab1 - 1, quantity);
+            }
+            start = newline + 1 - buffer.data();
+        }
+        if (eof) return true;
+
+        kept = end - start;
+        memmove(buffer.data(), buffer.data() + start, kept);
+        if (kept == buffer.size()) buffer.resize(buffer.size() * 2);   // Line longer than the buffer
+    }
+}
+
+// Benchmark mode: rows generated in memory
+
+struct Row {
+    uint32_t category;
+    uint32_t quantity;
+    uint64_t product;
+};
+
+// Best first: higher quantity, then lower product id
+static bool row_better(const Row& a, const Row& b) {
+    return a.quantity != b.quantity ? a.quantity > b.quantity : a.product < b.product;
+}
+
+struct RowBetter {
+    bool operator()(const Row& a, const Row& b) const { return row_better(a, b); }
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static int bench(size_t rows, size_t k, uint32_t category_count) {
+    printf("generating %zu rows, %u categories, k = %zu\n", rows, category_count, k);
+    std::vector<Row> data(rows);
+    uint64_t state = 88172645463325252ULL;
+    for (size_t i = 0; i < rows; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        // Heavy-tailed quantities: most products sell a few units, a few sell many
+        uint32_t u = (uint32_t)(state >> 40) | 1;
+        data[i] = Row{(uint32_t)(state % category_count), (1u << 24) / u, i};
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<TopK<Row, RowBetter>> tops(category_count, TopK<Row, RowBetter>(k));
+    for (const Row& row : data) {
+        TopK<Row, RowBetter>& top = tops[row.category];
+        const Row* weakest = top.weakest();
+        if (weakest && !row_better(row, *weakest)) continue;
+        top.offer(row);
+    }
+    std::vector<std::vector<Row>> heap_result(category_count);
+    for (uint32_t c = 0; c < category_count; c++) heap_result[c] = tops[c].take_sorted();
+    double heap_seconds = seconds_since(start);
+
+    // Baseline: sort every row by (category, rank), as mapper_sort does, and cut each
+    // category after k rows
+    start = std::chrono::steady_clock::now();
+    std::sort(data.begin(), data.end(), [](const Row& a, const Row& b) {
+        return a.category != b.category ? a.category < b.category : row_better(a, b);
+    });
+    std::vector<std::vector<Row>> sort_result(category_count);
+    for (const Row& row : data) {
+        if (sort_result[row.category].size() < k) sort_result[row.category].push_back(row);
+    }
+    double sort_seconds = seconds_since(start);
+
+    bool same = true;
+    for (uint32_t c = 0; c < category_count && same; c++) {
+        same = heap_result[c].size() == sort_result[c].size();
+        for (size_t i = 0; same && i < heap_result[c].size(); i++) {
+            same = heap_result[c][i].product == sort_result[c][i].product;
+        }
+    }
+    printf("bounded heaps: %8.3f s\n", heap_seconds);
+    printf("full sort:     %8.3f s  (%.1fx slower)\n", sort_seconds, sort_seconds / heap_seconds);
+    printf("rankings %s\n", same ? "identical" : "DIFFER");
+    return same ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    size_t k = 100;
+    size_t bench_rows = 0;
+    uint32_t category_count = 1000;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            k = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            category_count = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            bench_rows = strtoull(argv[++i], nullptr, 10);
+        } else if (argv[i][0] != '-' || argv[i][1] == '\0') {
+            path = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s [-k K] [file] | --bench ROWS [-k K] [-c CATEGORIES]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (k == 0 || category_count == 0) {
+        fprintf(stderr, "k and the category count must be positive\n");
+        return 2;
+    }
+    if (bench_rows > 0) return bench(bench_rows, k, category_count);
+
+    FILE* in = path && strcmp(path, "-") != 0 ? fopen(path, "rb") : stdin;
+    if (!in) {
+        perror(path);
+        return 1;
+    }
+    TopKRanker ranker(k);
+    bool ok = rank_stream(in, ranker);
+    if (in != stdin) fclose(in);
+    if (!ok) return 1;
+    ranker.print();
+    return 0;
+}